@@ -0,0 +1,88 @@
+// Сравнение ConcurrentMap (мьютекс + std::map на бакет) и LockFreeConcurrentMap
+// при накоплении значений из 1..N потоков.
+// Сборка: g++ -std=c++17 -O2 concurrent_map_benchmark.cpp -o concurrent_map_benchmark -ltbb -lpthread
+// Запуск: ./concurrent_map_benchmark [max_threads] [key_count] [operation_count]
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_map.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<int> GenerateKeys(size_t operation_count, int key_count) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, key_count - 1);
+    std::vector<int> keys(operation_count);
+    for (int& key : keys) {
+        key = distribution(generator);
+    }
+    return keys;
+}
+
+template <typename Map>
+double MeasureAccumulate(Map& map, const std::vector<int>& keys, int thread_count) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    const size_t part = (keys.size() + thread_count - 1) / thread_count;
+    for (int thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back([&map, &keys, part, thread]() {
+            const size_t last = std::min(keys.size(), (thread + 1) * part);
+            for (size_t i = thread * part; i < last; ++i) {
+                map[keys[i]].ref_to_value += 1.0;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Function>
+double MeasureSeconds(Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int max_threads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int key_count = argc > 2 ? std::atoi(argv[2]) : 100'000;
+    const size_t operation_count = argc > 3 ? std::atoll(argv[3]) : 4'000'000;
+    const std::vector<int> keys = GenerateKeys(operation_count, key_count);
+
+    std::cout << "map,threads,accumulate_mops_per_sec,drain_ms"s << std::endl;
+    for (int thread_count = 1; thread_count <= max_threads; ++thread_count) {
+        {
+            ConcurrentMap<int, double> map(128);
+            const double seconds = MeasureAccumulate(map, keys, thread_count);
+            size_t drained = 0;
+            const double drain_seconds = MeasureSeconds([&map, &drained]() {
+                drained = map.BuildOrdinaryMap().size();
+            });
+            std::cout << "mutex,"s << thread_count << ',' << operation_count / seconds / 1e6 << ','
+                << drain_seconds * 1e3 << std::endl;
+        }
+        {
+            LockFreeConcurrentMap<int, double> map(key_count);
+            const double seconds = MeasureAccumulate(map, keys, thread_count);
+            size_t drained = 0;
+            const double drain_seconds = MeasureSeconds([&map, &drained]() {
+                drained = map.BuildVector(std::execution::par).size();
+            });
+            std::cout << "lock_free,"s << thread_count << ',' << operation_count / seconds / 1e6 << ','
+                << drain_seconds * 1e3 << std::endl;
+        }
+    }
+    return 0;
+}
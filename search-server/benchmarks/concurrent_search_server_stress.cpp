@@ -0,0 +1,175 @@
+// Стресс-тест ConcurrentSearchServer: читатели непрерывно ищут, пока писатель
+// добавляет и удаляет документы. Проверяется, что запросы по неизменяемой части
+// индекса всегда дают один и тот же ответ, и сравниваются задержки чтения
+// с вариантом, где SearchServer защищён std::shared_mutex.
+// Сборка: g++ -std=c++17 -O2 concurrent_search_server_stress.cpp ../concurrent_search_server.cpp ../search_server.cpp
+//         ../posting_list.cpp ../term_dictionary.cpp ../query_cache.cpp ../string_processing.cpp ../document.cpp
+//         ../document_filter.cpp ../stop_words.cpp ../metrics.cpp
+//         -o concurrent_search_server_stress -ltbb -lpthread
+// Запуск: ./concurrent_search_server_stress [reader_count] [seconds]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_search_server.h"
+
+using namespace std::literals;
+
+namespace {
+
+const int STABLE_DOCUMENT_COUNT = 20'000;
+
+std::string MakeText(std::mt19937& generator, const std::string& prefix) {
+    std::uniform_int_distribution<int> word(0, 999);
+    std::string text;
+    for (int i = 0; i < 20; ++i) {
+        text += prefix + std::to_string(word(generator)) + ' ';
+    }
+    return text;
+}
+
+class SharedMutexSearchServer {
+public:
+    explicit SharedMutexSearchServer(const std::string& stop_words)
+        : server_(stop_words) {
+    }
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+        std::unique_lock lock(mutex_);
+        server_.AddDocument(document_id, document, status, ratings);
+    }
+
+    void RemoveDocument(int document_id) {
+        std::unique_lock lock(mutex_);
+        server_.RemoveDocument(document_id);
+    }
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const {
+        std::shared_lock lock(mutex_);
+        return server_.FindTopDocuments(raw_query);
+    }
+
+private:
+    SearchServer server_;
+    mutable std::shared_mutex mutex_;
+};
+
+struct StressResult {
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+    size_t query_count = 0;
+    size_t write_count = 0;
+    size_t mismatch_count = 0;
+};
+
+template <typename Server>
+StressResult RunStress(Server& server, int reader_count, double seconds) {
+    std::mt19937 generator(1);
+    for (int id = 0; id < STABLE_DOCUMENT_COUNT; ++id) {
+        server.AddDocument(id, MakeText(generator, "s"), DocumentStatus::ACTUAL, { id % 10 });
+    }
+    std::vector<std::string> queries;
+    for (int i = 0; i < 100; ++i) {
+        queries.push_back("s" + std::to_string(i) + " s" + std::to_string(i * 7 % 1000) + " -s" + std::to_string(i * 13 % 1000));
+    }
+    // Писатель трогает только документы со словами "v...", поэтому ответы
+    // на эти запросы не должны меняться
+    std::vector<std::vector<Document>> expected;
+    for (const std::string& query : queries) {
+        expected.push_back(server.FindTopDocuments(query));
+    }
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> write_count = 0;
+    std::thread writer([&server, &stop, &write_count]() {
+        std::mt19937 generator(2);
+        int next_id = STABLE_DOCUMENT_COUNT;
+        while (!stop) {
+            server.AddDocument(next_id, MakeText(generator, "v"), DocumentStatus::ACTUAL, { 1 });
+            if (next_id - STABLE_DOCUMENT_COUNT >= 1000) {
+                server.RemoveDocument(next_id - 1000);
+            }
+            ++next_id;
+            ++write_count;
+        }
+    });
+
+    std::vector<std::vector<double>> latencies(reader_count);
+    std::atomic<size_t> mismatch_count = 0;
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < reader_count; ++reader) {
+        readers.emplace_back([&, reader]() {
+            for (size_t i = reader; !stop; ++i) {
+                const size_t query = i % queries.size();
+                const auto start = std::chrono::steady_clock::now();
+                const auto documents = server.FindTopDocuments(queries[query]);
+                latencies[reader].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+                const bool is_same = documents.size() == expected[query].size()
+                    && std::equal(documents.begin(), documents.end(), expected[query].begin(),
+                        [](const Document& lhs, const Document& rhs) { return lhs.id == rhs.id; });
+                if (!is_same) {
+                    ++mismatch_count;
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    std::vector<double> all_latencies;
+    for (const auto& reader_latencies : latencies) {
+        all_latencies.insert(all_latencies.end(), reader_latencies.begin(), reader_latencies.end());
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    StressResult result;
+    result.query_count = all_latencies.size();
+    if (!all_latencies.empty()) {
+        result.p50_us = all_latencies[all_latencies.size() / 2];
+        result.p99_us = all_latencies[all_latencies.size() * 99 / 100];
+        result.max_us = all_latencies.back();
+    }
+    result.write_count = write_count;
+    result.mismatch_count = mismatch_count;
+    return result;
+}
+
+void PrintResult(const std::string& name, const StressResult& result) {
+    std::cout << name << ',' << result.query_count << ',' << result.write_count << ','
+        << result.p50_us << ',' << result.p99_us << ',' << result.max_us << ',' << result.mismatch_count << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int reader_count = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+
+    std::cout << "server,queries,writes,p50_us,p99_us,max_us,mismatches" << std::endl;
+    {
+        SharedMutexSearchServer server("and in with"s);
+        PrintResult("shared_mutex", RunStress(server, reader_count, seconds));
+    }
+    {
+        ConcurrentSearchServer server("and in with"s);
+        const StressResult result = RunStress(server, reader_count, seconds);
+        PrintResult("left_right", result);
+        if (result.mismatch_count != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#pragma once
+// Генератор синтетического корпуса для бенчмарков: слова выбираются по закону Ципфа,
+// длины документов — по логнормальному распределению, часть слов — стоп-слова,
+// часть документов — перестановки слов более ранних документов (дубликаты)
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../document.h"
+
+struct CorpusOptions {
+    int document_count = 20'000;
+    int vocabulary_size = 50'000;
+    double zipf_exponent = 1.0;
+    // Медиана и разброс логнормального распределения длины документа в словах
+    double median_document_length = 60.0;
+    double document_length_sigma = 0.6;
+    int max_document_length = 1'000;
+    int stop_word_count = 50;
+    double stop_word_ratio = 0.2;
+    double duplicate_ratio = 0.02;
+    int query_count = 2'000;
+    int max_plus_words = 3;
+    // Вероятность каждого из max_minus_words минус-слов в запросе
+    double minus_word_probability = 0.3;
+    int max_minus_words = 2;
+    uint32_t seed = 42;
+};
+
+struct GeneratedDocument {
+    int id;
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+struct Corpus {
+    std::string stop_words;
+    std::vector<GeneratedDocument> documents;
+    std::vector<std::string> queries;
+};
+
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options)
+        : options_(options), generator_(options.seed) {
+        // Функция распределения ранга слова: P(rank) ~ 1 / (rank + 1)^s
+        word_rank_cdf_.resize(options_.vocabulary_size);
+        double total = 0.0;
+        for (int rank = 0; rank < options_.vocabulary_size; ++rank) {
+            total += 1.0 / std::pow(rank + 1.0, options_.zipf_exponent);
+            word_rank_cdf_[rank] = total;
+        }
+        for (double& value : word_rank_cdf_) {
+            value /= total;
+        }
+    }
+
+    Corpus Generate() {
+        Corpus corpus;
+        for (int i = 0; i < options_.stop_word_count; ++i) {
+            corpus.stop_words += MakeStopWord(i) + ' ';
+        }
+
+        std::lognormal_distribution<double> length_distribution(std::log(options_.median_document_length), options_.document_length_sigma);
+        std::uniform_int_distribution<int> status_distribution(0, 3);
+        std::uniform_int_distribution<int> rating_distribution(-10, 10);
+        std::bernoulli_distribution is_duplicate(options_.duplicate_ratio);
+        corpus.documents.reserve(options_.document_count);
+        for (int id = 0; id < options_.document_count; ++id) {
+            std::vector<std::string> words;
+            if (id > 0 && is_duplicate(generator_)) {
+                const auto& original = corpus.documents[std::uniform_int_distribution<int>(0, id - 1)(generator_)];
+                words = SplitText(original.text);
+                std::shuffle(words.begin(), words.end(), generator_);
+            }
+            else {
+                const int length = std::clamp(static_cast<int>(length_distribution(generator_)), 1, options_.max_document_length);
+                for (int i = 0; i < length; ++i) {
+                    words.push_back(MakeDocumentWord());
+                }
+            }
+            std::vector<int> ratings(1 + id % 3);
+            for (int& rating : ratings) {
+                rating = rating_distribution(generator_);
+            }
+            corpus.documents.push_back({ id, JoinWords(words), static_cast<DocumentStatus>(status_distribution(generator_)), ratings });
+        }
+
+        std::uniform_int_distribution<int> plus_count_distribution(1, std::max(1, options_.max_plus_words));
+        std::bernoulli_distribution has_minus_word(options_.minus_word_probability);
+        corpus.queries.reserve(options_.query_count);
+        for (int i = 0; i < options_.query_count; ++i) {
+            std::vector<std::string> words;
+            const int plus_count = plus_count_distribution(generator_);
+            for (int j = 0; j < plus_count; ++j) {
+                words.push_back(MakeWord(SampleWordRank()));
+            }
+            for (int j = 0; j < options_.max_minus_words; ++j) {
+                if (has_minus_word(generator_)) {
+                    words.push_back('-' + MakeWord(SampleWordRank()));
+                }
+            }
+            corpus.queries.push_back(JoinWords(words));
+        }
+        return corpus;
+    }
+
+private:
+    CorpusOptions options_;
+    std::mt19937 generator_;
+    std::vector<double> word_rank_cdf_;
+
+    int SampleWordRank() {
+        const double value = std::uniform_real_distribution<double>(0.0, 1.0)(generator_);
+        const auto it = std::lower_bound(word_rank_cdf_.begin(), word_rank_cdf_.end(), value);
+        return static_cast<int>(std::min<size_t>(it - word_rank_cdf_.begin(), word_rank_cdf_.size() - 1));
+    }
+
+    std::string MakeDocumentWord() {
+        if (options_.stop_word_count > 0 && std::bernoulli_distribution(options_.stop_word_ratio)(generator_)) {
+            return MakeStopWord(std::uniform_int_distribution<int>(0, options_.stop_word_count - 1)(generator_));
+        }
+        return MakeWord(SampleWordRank());
+    }
+
+    // Слово ранга rank записывается буквами, чтобы длина росла с рангом, как в естественном языке
+    static std::string MakeWord(int rank) {
+        std::string word;
+        do {
+            word += static_cast<char>('a' + rank % 26);
+            rank /= 26;
+        } while (rank > 0);
+        return word;
+    }
+
+    static std::string MakeStopWord(int index) {
+        return "stop" + MakeWord(index);
+    }
+
+    static std::vector<std::string> SplitText(const std::string& text) {
+        std::vector<std::string> words;
+        size_t begin = 0;
+        while (begin < text.size()) {
+            const size_t end = std::min(text.find(' ', begin), text.size());
+            words.push_back(text.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return words;
+    }
+
+    static std::string JoinWords(const std::vector<std::string>& words) {
+        std::string text;
+        for (const std::string& word : words) {
+            if (!text.empty()) {
+                text += ' ';
+            }
+            text += word;
+        }
+        return text;
+    }
+};
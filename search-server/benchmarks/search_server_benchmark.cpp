@@ -0,0 +1,233 @@
+// Бенчмарк основных операций SearchServer на синтетическом корпусе (corpus_generator.h).
+// Для каждой операции печатается строка CSV: число операций, общее время, пропускная
+// способность и задержки p50/p99 одной операции. Параметры корпуса задаются аргументами
+// вида имя=значение, их итоговые значения печатаются в stderr, чтобы прогоны можно было сравнивать.
+// Сборка: g++ -std=c++17 -O2 search_server_benchmark.cpp ../search_server.cpp ../posting_list.cpp ../term_dictionary.cpp
+//         ../query_cache.cpp ../document_filter.cpp ../stop_words.cpp ../string_processing.cpp ../document.cpp
+//         ../process_queries.cpp ../remove_duplicates.cpp ../index_snapshot.cpp ../metrics.cpp
+//         -o search_server_benchmark -ltbb -lpthread
+// Запуск: ./search_server_benchmark [documents=20000] [vocabulary=50000] [zipf=1.0] [median_length=60]
+//         [length_sigma=0.6] [stop_words=50] [stop_ratio=0.2] [duplicates=0.02] [queries=2000]
+//         [plus_words=3] [minus_words=2] [minus_probability=0.3] [seed=42] [only=операция]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../process_queries.h"
+#include "../remove_duplicates.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkResult {
+    size_t operation_count = 0;
+    double seconds = 0.0;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+};
+
+BenchmarkResult Summarize(std::vector<double> latencies_us, double seconds) {
+    BenchmarkResult result;
+    result.operation_count = latencies_us.size();
+    result.seconds = seconds;
+    std::sort(latencies_us.begin(), latencies_us.end());
+    if (!latencies_us.empty()) {
+        result.p50_us = latencies_us[latencies_us.size() / 2];
+        result.p99_us = latencies_us[latencies_us.size() * 99 / 100];
+    }
+    return result;
+}
+
+// Вызывает operation(i) для i из [0, count) и замеряет каждый вызов
+template <typename Operation>
+BenchmarkResult Measure(size_t count, Operation operation) {
+    std::vector<double> latencies_us;
+    latencies_us.reserve(count);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const auto operation_start = Clock::now();
+        operation(i);
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - operation_start).count());
+    }
+    return Summarize(std::move(latencies_us), std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+class BenchmarkReport {
+public:
+    explicit BenchmarkReport(std::string only)
+        : only_(std::move(only)) {
+        std::cout << "operation,count,seconds,ops_per_second,p50_us,p99_us" << std::endl;
+    }
+
+    bool IsEnabled(const std::string& operation) const {
+        return only_.empty() || operation.find(only_) != std::string::npos;
+    }
+
+    template <typename Operation>
+    void Run(const std::string& operation, size_t count, Operation operation_fn) {
+        if (!IsEnabled(operation)) {
+            return;
+        }
+        const BenchmarkResult result = Measure(count, operation_fn);
+        std::cout << operation << ',' << result.operation_count << ',' << result.seconds << ','
+            << (result.seconds > 0.0 ? result.operation_count / result.seconds : 0.0) << ','
+            << result.p50_us << ',' << result.p99_us << std::endl;
+    }
+
+private:
+    std::string only_;
+};
+
+std::map<std::string, std::string> ParseArguments(int argc, char** argv) {
+    std::map<std::string, std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const size_t separator = argument.find('=');
+        if (separator == std::string::npos) {
+            std::cerr << "ignored argument: " << argument << std::endl;
+            continue;
+        }
+        arguments[argument.substr(0, separator)] = argument.substr(separator + 1);
+    }
+    return arguments;
+}
+
+CorpusOptions MakeCorpusOptions(const std::map<std::string, std::string>& arguments) {
+    CorpusOptions options;
+    const auto read = [&arguments](const std::string& name, auto& value) {
+        const auto it = arguments.find(name);
+        if (it != arguments.end()) {
+            value = static_cast<std::decay_t<decltype(value)>>(std::atof(it->second.c_str()));
+        }
+        std::cerr << name << '=' << value << std::endl;
+    };
+    read("documents", options.document_count);
+    read("vocabulary", options.vocabulary_size);
+    read("zipf", options.zipf_exponent);
+    read("median_length", options.median_document_length);
+    read("length_sigma", options.document_length_sigma);
+    read("stop_words", options.stop_word_count);
+    read("stop_ratio", options.stop_word_ratio);
+    read("duplicates", options.duplicate_ratio);
+    read("queries", options.query_count);
+    read("plus_words", options.max_plus_words);
+    read("minus_words", options.max_minus_words);
+    read("minus_probability", options.minus_word_probability);
+    read("seed", options.seed);
+    return options;
+}
+
+void AddCorpus(SearchServer& search_server, const Corpus& corpus) {
+    for (const GeneratedDocument& document : corpus.documents) {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const auto arguments = ParseArguments(argc, argv);
+    const CorpusOptions options = MakeCorpusOptions(arguments);
+    const auto only = arguments.find("only");
+    BenchmarkReport report(only == arguments.end() ? ""s : only->second);
+
+    const Corpus corpus = CorpusGenerator(options).Generate();
+    const auto& documents = corpus.documents;
+    const auto& queries = corpus.queries;
+
+    SearchServer search_server(corpus.stop_words);
+    report.Run("AddDocument", documents.size(), [&](size_t i) {
+        search_server.AddDocument(documents[i].id, documents[i].text, documents[i].status, documents[i].ratings);
+    });
+    if (!report.IsEnabled("AddDocument")) {
+        AddCorpus(search_server, corpus);
+    }
+
+    const auto predicate = [](int document_id, DocumentStatus status, int rating) {
+        return document_id % 2 == 0 && rating > 0;
+    };
+    report.Run("FindTopDocuments/seq", queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::seq, queries[i]);
+    });
+    report.Run("FindTopDocuments/par", queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::par, queries[i]);
+    });
+    report.Run("FindTopDocuments/seq/predicate", queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::seq, queries[i], predicate);
+    });
+    report.Run("FindTopDocuments/par/predicate", queries.size(), [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::par, queries[i], predicate);
+    });
+
+    std::mt19937 generator(options.seed);
+    std::vector<int> match_ids(queries.size());
+    for (int& document_id : match_ids) {
+        document_id = documents[std::uniform_int_distribution<size_t>(0, documents.size() - 1)(generator)].id;
+    }
+    report.Run("MatchDocument/seq", queries.size(), [&](size_t i) {
+        search_server.MatchDocument(std::execution::seq, queries[i], match_ids[i]);
+    });
+    report.Run("MatchDocument/par", queries.size(), [&](size_t i) {
+        search_server.MatchDocument(std::execution::par, queries[i], match_ids[i]);
+    });
+
+    // Сопоставление запроса со страницей выдачи, как при подсветке найденных слов
+    const size_t page_size = 20;
+    std::vector<int> page_ids(std::min(page_size, match_ids.size()));
+    std::copy(match_ids.begin(), match_ids.begin() + page_ids.size(), page_ids.begin());
+    DocumentMatches matches;
+    report.Run("MatchDocuments/page", queries.size(), [&](size_t i) {
+        search_server.MatchDocuments(queries[i], page_ids, matches);
+    });
+
+    // Пакетные операции замеряются целиком, задержка — время одного пакета
+    const size_t batch_repeat_count = 5;
+    report.Run("ProcessQueries", batch_repeat_count, [&](size_t) {
+        ProcessQueries(search_server, queries);
+    });
+    report.Run("ProcessQueriesBatch", batch_repeat_count, [&](size_t) {
+        ProcessQueriesBatch(search_server, queries);
+    });
+
+    // Разрушающие операции выполняются на свежих копиях индекса
+    std::vector<int> remove_ids;
+    for (const GeneratedDocument& document : documents) {
+        remove_ids.push_back(document.id);
+    }
+    std::shuffle(remove_ids.begin(), remove_ids.end(), generator);
+    remove_ids.resize(remove_ids.size() / 10);
+    if (report.IsEnabled("RemoveDocument/seq")) {
+        SearchServer server(corpus.stop_words);
+        AddCorpus(server, corpus);
+        report.Run("RemoveDocument/seq", remove_ids.size(), [&](size_t i) {
+            server.RemoveDocument(std::execution::seq, remove_ids[i]);
+        });
+    }
+    if (report.IsEnabled("RemoveDocument/par")) {
+        SearchServer server(corpus.stop_words);
+        AddCorpus(server, corpus);
+        report.Run("RemoveDocument/par", remove_ids.size(), [&](size_t i) {
+            server.RemoveDocument(std::execution::par, remove_ids[i]);
+        });
+    }
+    if (report.IsEnabled("RemoveDuplicates")) {
+        SearchServer server(corpus.stop_words);
+        AddCorpus(server, corpus);
+        report.Run("RemoveDuplicates", 1, [&](size_t) {
+            RemoveDuplicates(server);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Проверка снимков индекса: выдача SearchServer, SearchServer::LoadSnapshot и MappedSearchServer
+// совпадает для всех статусов, пустой сервер переживает сохранение, а повреждённые файлы
+// (контрольная сумма, версия, обрезанный файл, любой изменённый байт) отвергаются, а снимки
+// одинаковых индексов совпадают побайтно. MappedSearchServer без проверки списков вхождений
+// не читает за пределами снимка, даже если вхождения и документы повреждены.
+// Сборка: g++ -std=c++17 -O2 snapshot_test.cpp ../index_snapshot.cpp ../search_server.cpp ../posting_list.cpp
+//         ../term_dictionary.cpp ../query_cache.cpp ../document_filter.cpp ../stop_words.cpp
+//         ../string_processing.cpp ../document.cpp ../metrics.cpp
+//         -o snapshot_test -ltbb -lpthread
+// Запуск: ./snapshot_test [documents=2000]
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "corpus_generator.h"
+#include "../index_snapshot.h"
+#include "../search_server.h"
+
+using namespace std::literals;
+
+namespace {
+
+int failure_count = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failure_count;
+        std::cerr << "FAILED: " << message << '\n';
+    }
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+void WriteFile(const std::string& path, const std::string& bytes) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(bytes.data(), bytes.size());
+}
+
+bool AreEqual(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].id != rhs[i].id || lhs[i].rating != rhs[i].rating || std::abs(lhs[i].relevance - rhs[i].relevance) >= EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Сравнивает выдачу трёх серверов по каждому статусу, по предикату и без фильтра
+void CheckSameResults(const SearchServer& server, const std::vector<std::string>& queries, const std::string& path) {
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    const MappedSearchServer mapped(path);
+    Check(loaded.GetDocumentCount() == server.GetDocumentCount(), "LoadSnapshot document count");
+    Check(mapped.GetDocumentCount() == server.GetDocumentCount(), "MappedSearchServer document count");
+
+    const auto predicate = [](int document_id, DocumentStatus, int rating) {
+        return document_id % 3 != 0 && rating >= 0;
+    };
+    for (const std::string& query : queries) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED, DocumentStatus::REMOVED }) {
+            const std::vector<Document> expected = server.FindTopDocuments(query, status);
+            Check(AreEqual(loaded.FindTopDocuments(query, status), expected), "LoadSnapshot, status "s + std::to_string(static_cast<int>(status)) + ": " + query);
+            Check(AreEqual(mapped.FindTopDocuments(query, status), expected), "MappedSearchServer, status "s + std::to_string(static_cast<int>(status)) + ": " + query);
+        }
+        const std::vector<Document> expected = server.FindTopDocuments(query, predicate);
+        Check(AreEqual(loaded.FindTopDocuments(query, predicate), expected), "LoadSnapshot, predicate: " + query);
+        Check(AreEqual(mapped.FindTopDocuments(query, predicate), expected), "MappedSearchServer, predicate: " + query);
+    }
+}
+
+// Файл должен отвергаться и LoadSnapshot, и MappedSearchServer с проверкой списков вхождений;
+// expected_error — часть сообщения исключения, пустая строка принимает любое
+void CheckRejected(const std::string& bytes, const std::string& path, const std::string& expected_error, const std::string& description) {
+    WriteFile(path, bytes);
+    const auto check_error = [&](auto load, const std::string& loader) {
+        try {
+            load();
+            Check(false, loader + " accepted " + description);
+        }
+        catch (const std::runtime_error& error) {
+            Check(std::string_view(error.what()).find(expected_error) != std::string_view::npos,
+                loader + " rejected " + description + " with unexpected error: " + error.what());
+        }
+    };
+    check_error([&] { SearchServer::LoadSnapshot(path); }, "LoadSnapshot");
+    check_error([&] { MappedSearchServer mapped(path, true); }, "MappedSearchServer");
+}
+
+Corpus MakeCorpus(int document_count) {
+    CorpusOptions options;
+    options.document_count = document_count;
+    options.vocabulary_size = 5'000;
+    options.query_count = 300;
+    return CorpusGenerator(options).Generate();
+}
+
+SearchServer MakeServer(const Corpus& corpus) {
+    SearchServer server(corpus.stop_words);
+    for (const GeneratedDocument& document : corpus.documents) {
+        server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    // Удалённые документы оставляют дыры в порядковых номерах, которые снимок уплотняет
+    for (const GeneratedDocument& document : corpus.documents) {
+        if (document.id % 7 == 0) {
+            server.RemoveDocument(document.id);
+        }
+    }
+    return server;
+}
+
+void TestRoundTrip(const Corpus& corpus, const std::string& path) {
+    const SearchServer server = MakeServer(corpus);
+    server.SaveSnapshot(path);
+    CheckSameResults(server, corpus.queries, path);
+}
+
+// Снимки двух независимо построенных одинаковых индексов совпадают побайтно:
+// в файл не попадает содержимое памяти процесса
+void TestReproducible(const Corpus& corpus, const std::string& path) {
+    MakeServer(corpus).SaveSnapshot(path);
+    const std::string first = ReadFile(path);
+    MakeServer(corpus).SaveSnapshot(path);
+    Check(ReadFile(path) == first, "snapshots of identical indexes differ");
+}
+
+void TestEmptyServer(const std::string& path) {
+    const SearchServer server("и в на"s);
+    server.SaveSnapshot(path);
+    CheckSameResults(server, { "кот"s, "кот -пёс"s, "и"s }, path);
+}
+
+void TestCorruptedFiles(const std::string& path) {
+    SearchServer server("и в на"s);
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    server.SaveSnapshot(path);
+    const std::string bytes = ReadFile(path);
+    SnapshotHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    std::string corrupted = bytes;
+    corrupted[header.sections[SNAPSHOT_POSTINGS].offset] ^= 1;
+    CheckRejected(corrupted, path, "section checksum mismatch", "a corrupted posting");
+    // Без verify_postings тот же файл открывается, а повреждение находит VerifyPostings
+    {
+        const MappedSearchServer mapped(path);
+        try {
+            mapped.VerifyPostings();
+            Check(false, "VerifyPostings accepted a corrupted posting");
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    // Заголовок с другой версией и верной контрольной суммой отвергается именно из-за версии
+    SnapshotHeader future_header = header;
+    future_header.version = SNAPSHOT_VERSION + 1;
+    future_header.header_checksum = 0;
+    future_header.header_checksum = ComputeSnapshotChecksum(reinterpret_cast<const char*>(&future_header), sizeof(future_header));
+    corrupted = bytes;
+    std::memcpy(corrupted.data(), &future_header, sizeof(future_header));
+    CheckRejected(corrupted, path, "unsupported version", "a newer version");
+
+    CheckRejected(bytes.substr(0, sizeof(SnapshotHeader) / 2), path, "too small", "a truncated header");
+    CheckRejected(bytes.substr(0, bytes.size() - 1), path, "out of bounds", "a truncated last section");
+    CheckRejected(bytes + '\0', path, "after the last section", "trailing data");
+
+    // Заголовок, выравнивание и секции покрыты проверками целиком, поэтому
+    // непроверяемых байт нет: изменение любого байта должно быть замечено
+    for (size_t offset = 0; offset < bytes.size(); ++offset) {
+        corrupted = bytes;
+        corrupted[offset] ^= 0x5A;
+        CheckRejected(corrupted, path, ""s, "a flipped byte at offset " + std::to_string(offset));
+    }
+    std::cout << "byte-flip sweep: " << bytes.size() << " bytes" << std::endl;
+}
+
+// Без проверки списков вхождений повреждённые вхождения и документы обнаруживаются
+// при открытии или чтении, а не приводят к обращению за пределы отображения
+void TestUncheckedSnapshot(const std::string& path) {
+    SearchServer server("и в на"s);
+    server.AddDocument(1, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "ухоженный пёс выразительные глаза"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    server.SaveSnapshot(path);
+    const std::string bytes = ReadFile(path);
+    SnapshotHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    const auto check_query_rejected = [&path](const std::string& corrupted, const std::string& description) {
+        WriteFile(path, corrupted);
+        for (const std::string_view query : { "кот -пёс"sv, "пёс -кот"sv }) {
+            try {
+                const MappedSearchServer mapped(path);
+                mapped.FindTopDocuments(query);
+                Check(false, "MappedSearchServer without posting verification accepted " + description);
+            }
+            catch (const std::runtime_error&) {
+            }
+        }
+    };
+
+    std::string corrupted = bytes;
+    const SnapshotSection& postings = header.sections[SNAPSHOT_POSTINGS];
+    for (uint64_t offset = postings.offset; offset < postings.offset + postings.size; offset += sizeof(SnapshotPosting)) {
+        const int32_t document_ordinal = 50'000'000;
+        std::memcpy(corrupted.data() + offset, &document_ordinal, sizeof(document_ordinal));
+    }
+    check_query_rejected(corrupted, "out-of-range posting ordinals"s);
+
+    corrupted = bytes;
+    const SnapshotSection& documents = header.sections[SNAPSHOT_DOCUMENTS];
+    for (uint64_t offset = documents.offset; offset < documents.offset + documents.size; offset += sizeof(SnapshotDocument)) {
+        const int32_t status = 1'000;
+        std::memcpy(corrupted.data() + offset + offsetof(SnapshotDocument, status), &status, sizeof(status));
+    }
+    check_query_rejected(corrupted, "out-of-range document statuses"s);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const int document_count = argc > 1 ? std::atoi(argv[1]) : 2'000;
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server_snapshot_test.bin").string();
+
+    const Corpus corpus = MakeCorpus(document_count);
+    TestRoundTrip(corpus, path);
+    TestReproducible(corpus, path);
+    TestEmptyServer(path);
+    TestCorruptedFiles(path);
+    TestUncheckedSnapshot(path);
+    std::filesystem::remove(path);
+
+    if (failure_count > 0) {
+        std::cerr << failure_count << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "OK" << std::endl;
+    return EXIT_SUCCESS;
+}
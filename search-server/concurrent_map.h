@@ -1,11 +1,18 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <execution>
 #include <future>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std::string_literals;
@@ -44,3 +51,175 @@ private:
     };
     std::vector<Bucket> mp_;
 };
+
+// Вариант ConcurrentMap без блокировок: открытая адресация с линейным пробированием
+// в таблице фиксированного размера. Ключ вставляется через CAS, значение накапливается
+// атомарно. Таблица не растёт, поэтому её размер задаётся ожидаемым числом ключей.
+// Максимальное значение типа Key зарезервировано под пустую ячейку.
+template <typename Key, typename Value>
+class LockFreeConcurrentMap {
+public:
+    static_assert(std::is_integral_v<Key>, "LockFreeConcurrentMap support only integer keys");
+    static_assert(std::is_arithmetic_v<Value>, "LockFreeConcurrentMap support only arithmetic values");
+
+    class ValueRef {
+    public:
+        explicit ValueRef(std::atomic<Value>& value) : value_(value) {}
+
+        ValueRef& operator+=(Value delta) {
+            FetchAdd(value_, delta);
+            return *this;
+        }
+
+        ValueRef& operator-=(Value delta) {
+            FetchAdd(value_, -delta);
+            return *this;
+        }
+
+        ValueRef& operator=(Value value) {
+            value_.store(value, std::memory_order_relaxed);
+            return *this;
+        }
+
+        operator Value() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<Value>& value_;
+    };
+
+    struct Access {
+        ValueRef ref_to_value;
+    };
+
+    explicit LockFreeConcurrentMap(size_t expected_key_count)
+        : capacity_(RoundUpToPowerOfTwo(std::max<size_t>(expected_key_count * 2, 16)))
+        , slots_(std::make_unique<Slot[]>(capacity_)) {
+    }
+
+    Access operator[](const Key& key) {
+        return { ValueRef(FindOrInsert(key).value) };
+    }
+
+    void Add(const Key& key, Value delta) {
+        FetchAdd(FindOrInsert(key).value, delta);
+    }
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+    // Методы ниже нельзя вызывать одновременно с записью в таблицу
+    std::map<Key, Value> BuildOrdinaryMap() const {
+        std::map<Key, Value> result;
+        for (size_t i = 0; i < capacity_; ++i) {
+            const Key key = slots_[i].key.load(std::memory_order_acquire);
+            if (key != EMPTY_KEY) {
+                result.emplace(key, slots_[i].value.load(std::memory_order_relaxed));
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::pair<Key, Value>> BuildVector() const {
+        std::vector<std::pair<Key, Value>> result;
+        for (size_t i = 0; i < capacity_; ++i) {
+            const Key key = slots_[i].key.load(std::memory_order_acquire);
+            if (key != EMPTY_KEY) {
+                result.emplace_back(key, slots_[i].value.load(std::memory_order_relaxed));
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::pair<Key, Value>> BuildVector(const std::execution::parallel_policy& policy) const {
+        // Сначала каждый поток считает занятые ячейки своей части, затем по
+        // префиксным суммам пишет их в общий вектор без синхронизации
+        const size_t chunk_count = std::min(capacity_, static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())) * 4);
+        const size_t chunk_size = (capacity_ + chunk_count - 1) / chunk_count;
+        std::vector<size_t> chunks(chunk_count);
+        std::iota(chunks.begin(), chunks.end(), 0);
+
+        std::vector<size_t> offsets(chunk_count + 1);
+        std::for_each(policy, chunks.begin(), chunks.end(),
+            [this, chunk_size, &offsets](size_t chunk) {
+                const size_t last = std::min(capacity_, (chunk + 1) * chunk_size);
+                for (size_t i = chunk * chunk_size; i < last; ++i) {
+                    if (slots_[i].key.load(std::memory_order_acquire) != EMPTY_KEY) {
+                        ++offsets[chunk + 1];
+                    }
+                }
+            });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<std::pair<Key, Value>> result(offsets.back());
+        std::for_each(policy, chunks.begin(), chunks.end(),
+            [this, chunk_size, &offsets, &result](size_t chunk) {
+                const size_t last = std::min(capacity_, (chunk + 1) * chunk_size);
+                size_t position = offsets[chunk];
+                for (size_t i = chunk * chunk_size; i < last; ++i) {
+                    const Key key = slots_[i].key.load(std::memory_order_acquire);
+                    if (key != EMPTY_KEY) {
+                        result[position++] = { key, slots_[i].value.load(std::memory_order_relaxed) };
+                    }
+                }
+            });
+        return result;
+    }
+
+private:
+    static constexpr Key EMPTY_KEY = std::numeric_limits<Key>::max();
+
+    struct Slot {
+        std::atomic<Key> key{ EMPTY_KEY };
+        std::atomic<Value> value{ Value{} };
+    };
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static void FetchAdd(std::atomic<Value>& value, Value delta) {
+        if constexpr (std::is_integral_v<Value>) {
+            value.fetch_add(delta, std::memory_order_relaxed);
+        }
+        else {
+            Value expected = value.load(std::memory_order_relaxed);
+            while (!value.compare_exchange_weak(expected, expected + delta, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    Slot& FindOrInsert(const Key& key) {
+        if (key == EMPTY_KEY) {
+            throw std::invalid_argument("LockFreeConcurrentMap: reserved key");
+        }
+        const uint64_t hash = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+        size_t index = static_cast<size_t>(hash ^ (hash >> 32)) & (capacity_ - 1);
+        for (size_t probe = 0; probe < capacity_; ++probe) {
+            Slot& slot = slots_[index];
+            Key current = slot.key.load(std::memory_order_acquire);
+            if (current == key) {
+                return slot;
+            }
+            if (current == EMPTY_KEY) {
+                if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    return slot;
+                }
+                if (current == key) {
+                    return slot;
+                }
+            }
+            index = (index + 1) & (capacity_ - 1);
+        }
+        throw std::length_error("LockFreeConcurrentMap: table is full");
+    }
+};
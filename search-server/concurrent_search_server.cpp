@@ -0,0 +1,66 @@
+#include "concurrent_search_server.h"
+
+#include <thread>
+
+void ConcurrentSearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Write([document_id, document, status, &ratings](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+        return true;
+    });
+}
+
+IngestionStats ConcurrentSearchServer::AddDocuments(const std::vector<DocumentInput>& documents) {
+    return Write([&documents](SearchServer& server) {
+        return server.AddDocuments(std::execution::par, documents);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+        return true;
+    });
+}
+
+void ConcurrentSearchServer::SetMaxResultDocumentCount(int count) {
+    Write([count](SearchServer& server) {
+        server.SetMaxResultDocumentCount(count);
+        return true;
+    });
+}
+
+void ConcurrentSearchServer::SetQueryCacheCapacity(size_t capacity) {
+    Write([capacity](SearchServer& server) {
+        server.SetQueryCacheCapacity(capacity);
+        return true;
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const {
+    return Read([raw_query, filter_status](const SearchServer& server) {
+        return server.FindTopDocuments(raw_query, filter_status);
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ConcurrentSearchServer::MatchDocument(const std::string_view raw_query, int document_id) const {
+    return Read([raw_query, document_id](const SearchServer& server) {
+        const auto [words, status] = server.MatchDocument(raw_query, document_id);
+        return std::tuple<std::vector<std::string>, DocumentStatus>(std::vector<std::string>(words.begin(), words.end()), status);
+    });
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+void ConcurrentSearchServer::WaitForReaders(int generation) const {
+    while (readers_[generation].count.load() != 0) {
+        std::this_thread::yield();
+    }
+}
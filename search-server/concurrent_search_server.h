@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <execution>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Обёртка над SearchServer, позволяющая искать одновременно с добавлением и удалением
+// документов (схема Left-Right). Хранятся две копии индекса: читатели работают с
+// опубликованной, писатель изменяет вторую, публикует её и, дождавшись ухода читателей
+// со старой копии, повторяет на ней ту же операцию. Читатели никогда не ждут
+// блокировок — только атомарно отмечаются в счётчике своего поколения.
+// Писатели выполняются по одному.
+class ConcurrentSearchServer {
+public:
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words);
+
+    explicit ConcurrentSearchServer(const std::string_view stop_words_text)
+        : ConcurrentSearchServer(SplitIntoWords(stop_words_text)) {
+    }
+
+    explicit ConcurrentSearchServer(const std::string& stop_words_text)
+        : ConcurrentSearchServer(SplitIntoWords(stop_words_text)) {
+    }
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    IngestionStats AddDocuments(const std::vector<DocumentInput>& documents);
+    void RemoveDocument(int document_id);
+
+    void SetMaxResultDocumentCount(int count);
+    void SetQueryCacheCapacity(size_t capacity);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+
+    // Возвращённые string_view указывают в словарь копии индекса и могут стать
+    // недействительными после следующей записи, поэтому слова копируются
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Выполняет function(const SearchServer&) на опубликованной копии индекса.
+    // Ссылки на данные индекса нельзя сохранять за пределами function
+    template <typename Function>
+    auto Read(Function function) const;
+
+private:
+    std::array<SearchServer, 2> servers_;
+    // Индекс копии, открытой для чтения
+    std::atomic<int> published_{ 0 };
+    // Поколение, в счётчике которого отмечаются новые читатели
+    std::atomic<int> reader_generation_{ 0 };
+    struct alignas(64) ReaderCounter {
+        std::atomic<int> count{ 0 };
+    };
+    mutable std::array<ReaderCounter, 2> readers_;
+    std::mutex write_mutex_;
+
+    template <typename Operation>
+    auto Write(Operation operation);
+    void WaitForReaders(int generation) const;
+};
+
+template <typename StringContainer>
+ConcurrentSearchServer::ConcurrentSearchServer(const StringContainer& stop_words)
+    : servers_{ SearchServer(stop_words), SearchServer(stop_words) } {
+}
+
+template <typename Function>
+auto ConcurrentSearchServer::Read(Function function) const {
+    class ReaderGuard {
+    public:
+        explicit ReaderGuard(std::atomic<int>& count)
+            : count_(count) {
+            count_.fetch_add(1);
+        }
+        ~ReaderGuard() {
+            count_.fetch_sub(1);
+        }
+    private:
+        std::atomic<int>& count_;
+    };
+
+    const ReaderGuard guard(readers_[reader_generation_.load()].count);
+    return function(servers_[published_.load()]);
+}
+
+template <typename Operation>
+auto ConcurrentSearchServer::Write(Operation operation) {
+    std::lock_guard guard(write_mutex_);
+    const int hidden = 1 - published_.load();
+    // Если операция выбросит исключение, копия не изменится: SearchServer
+    // проверяет входные данные до изменения индекса
+    auto result = operation(servers_[hidden]);
+    published_.store(hidden);
+
+    // Новые читатели переводятся в другое поколение; после того как оба поколения
+    // опустеют, ни один читатель уже не видит старую копию
+    const int generation = reader_generation_.load();
+    WaitForReaders(1 - generation);
+    reader_generation_.store(1 - generation);
+    WaitForReaders(generation);
+
+    // Повтор той же записи не должен второй раз попасть в метрики
+    const MetricsPause metrics_pause;
+    operation(servers_[1 - hidden]);
+    return result;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return Read([raw_query, document_predicate](const SearchServer& server) {
+        return server.FindTopDocuments(raw_query, document_predicate);
+    });
+}
@@ -0,0 +1,48 @@
+#include "document_filter.h"
+
+namespace {
+uint32_t GetStatusBit(DocumentStatus status) {
+    return 1u << static_cast<int>(status);
+}
+}
+
+DocumentFilter::DocumentFilter(DocumentStatus status)
+    : status_mask(GetStatusBit(status)) {
+}
+
+DocumentFilter::DocumentFilter(std::initializer_list<DocumentStatus> statuses)
+    : status_mask(0) {
+    for (const DocumentStatus status : statuses) {
+        status_mask |= GetStatusBit(status);
+    }
+}
+
+DocumentFilter& DocumentFilter::SetRatingRange(int min, int max) {
+    min_rating = min;
+    max_rating = max;
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::SetIdRange(int min, int max) {
+    min_id = min;
+    max_id = max;
+    return *this;
+}
+
+bool DocumentFilter::HasStatus(DocumentStatus status) const {
+    return (status_mask & GetStatusBit(status)) != 0;
+}
+
+bool DocumentFilter::HasRatingRange() const {
+    return min_rating != INT_MIN || max_rating != INT_MAX;
+}
+
+bool DocumentFilter::HasIdRange() const {
+    return min_id != INT_MIN || max_id != INT_MAX;
+}
+
+bool DocumentFilter::operator()(int document_id, DocumentStatus status, int rating) const {
+    return HasStatus(status)
+        && rating >= min_rating && rating <= max_rating
+        && document_id >= min_id && document_id <= max_id;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+
+#include "document.h"
+
+const int DOCUMENT_STATUS_COUNT = 4;
+
+// Структурированный фильтр: набор допустимых статусов, диапазоны рейтинга и id
+// (границы включаются). В отличие от произвольного предиката SearchServer применяет его
+// по заранее построенным битовым маскам статусов, не вызывая функцию для каждого вхождения.
+// Фильтр можно передать и как обычный предикат — например, ShardedSearchServer или RequestQueue.
+struct DocumentFilter {
+    static constexpr uint32_t ALL_STATUSES = (1u << DOCUMENT_STATUS_COUNT) - 1;
+
+    uint32_t status_mask = ALL_STATUSES;
+    int min_rating = INT_MIN;
+    int max_rating = INT_MAX;
+    int min_id = INT_MIN;
+    int max_id = INT_MAX;
+
+    DocumentFilter() = default;
+    explicit DocumentFilter(DocumentStatus status);
+    DocumentFilter(std::initializer_list<DocumentStatus> statuses);
+
+    DocumentFilter& SetRatingRange(int min, int max);
+    DocumentFilter& SetIdRange(int min, int max);
+
+    bool HasStatus(DocumentStatus status) const;
+    bool HasRatingRange() const;
+    bool HasIdRange() const;
+
+    bool operator()(int document_id, DocumentStatus status, int rating) const;
+};
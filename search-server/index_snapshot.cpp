@@ -0,0 +1,408 @@
+#include "index_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_USE_MMAP
+#endif
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = { 'S', 'S', 'N', 'A', 'P', 'S', 'H', 'T' };
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+size_t AlignSnapshotOffset(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+uint64_t ComputeHeaderChecksum(SnapshotHeader header) {
+    header.header_checksum = 0;
+    return ComputeSnapshotChecksum(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+template <typename Record>
+std::string_view AsBytes(const std::vector<Record>& records) {
+    return { reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record) };
+}
+
+}  // namespace
+
+uint64_t ComputeSnapshotChecksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+SnapshotFile::SnapshotFile(const std::string& path, bool verify_postings) {
+#ifdef SNAPSHOT_USE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("SnapshotFile: cannot open " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("SnapshotFile: cannot stat " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("SnapshotFile: cannot map " + path);
+        }
+        data_ = static_cast<const char*>(mapping);
+    }
+    else {
+        close(fd);
+    }
+#else
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input) {
+        throw std::runtime_error("SnapshotFile: cannot open " + path);
+    }
+    buffer_.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(buffer_.data(), buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+    try {
+        Validate(verify_postings);
+    }
+    catch (...) {
+#ifdef SNAPSHOT_USE_MMAP
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        throw;
+    }
+}
+
+SnapshotFile::~SnapshotFile() {
+#ifdef SNAPSHOT_USE_MMAP
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+const SnapshotHeader& SnapshotFile::GetHeader() const {
+    return *reinterpret_cast<const SnapshotHeader*>(data_);
+}
+
+std::string_view SnapshotFile::GetSection(SnapshotSectionId id) const {
+    const SnapshotSection& section = GetHeader().sections[id];
+    return { data_ + section.offset, static_cast<size_t>(section.size) };
+}
+
+std::vector<std::string_view> SnapshotFile::GetStopWords() const {
+    std::vector<std::string_view> stop_words;
+    std::string_view bytes = GetSection(SNAPSHOT_STOP_WORDS);
+    while (!bytes.empty()) {
+        const size_t end = bytes.find('\0');
+        if (end == std::string_view::npos) {
+            throw std::runtime_error("SnapshotFile: corrupted stop words");
+        }
+        stop_words.push_back(bytes.substr(0, end));
+        bytes.remove_prefix(end + 1);
+    }
+    return stop_words;
+}
+
+void SnapshotFile::Validate(bool verify_postings) const {
+    if (size_ < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("SnapshotFile: file is too small");
+    }
+    const SnapshotHeader& header = GetHeader();
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw std::runtime_error("SnapshotFile: not a snapshot");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("SnapshotFile: unsupported version " + std::to_string(header.version));
+    }
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER || header.posting_size != sizeof(SnapshotPosting)) {
+        throw std::runtime_error("SnapshotFile: incompatible byte order or layout");
+    }
+    if (ComputeHeaderChecksum(header) != header.header_checksum) {
+        throw std::runtime_error("SnapshotFile: header checksum mismatch");
+    }
+    // Секции идут подряд в порядке идентификаторов, а выравнивание между ними заполнено нулями,
+    // поэтому в файле нет байт, не покрытых проверками
+    uint64_t end = sizeof(SnapshotHeader);
+    for (const SnapshotSection& section : header.sections) {
+        if (section.offset != AlignSnapshotOffset(end) || section.offset > size_ || section.size > size_ - section.offset) {
+            throw std::runtime_error("SnapshotFile: section out of bounds");
+        }
+        if (std::any_of(data_ + end, data_ + section.offset, [](char byte) { return byte != 0; })) {
+            throw std::runtime_error("SnapshotFile: non-zero padding");
+        }
+        end = section.offset + section.size;
+    }
+    if (end != size_) {
+        throw std::runtime_error("SnapshotFile: unexpected data after the last section");
+    }
+    // Списки вхождений занимают почти весь файл, поэтому их проверка отложена до VerifyPostings
+    for (int id = 0; id < SNAPSHOT_SECTION_COUNT; ++id) {
+        if (id != SNAPSHOT_POSTINGS) {
+            VerifySectionChecksum(static_cast<SnapshotSectionId>(id));
+        }
+    }
+    if (header.sections[SNAPSHOT_TERMS].size != header.term_count * sizeof(SnapshotTerm)
+        || header.sections[SNAPSHOT_DOCUMENTS].size != header.document_count * sizeof(SnapshotDocument)
+        || header.sections[SNAPSHOT_POSTINGS].size % sizeof(SnapshotPosting) != 0) {
+        throw std::runtime_error("SnapshotFile: section size mismatch");
+    }
+
+    const uint64_t posting_count = header.sections[SNAPSHOT_POSTINGS].size / sizeof(SnapshotPosting);
+    const uint64_t text_size = header.sections[SNAPSHOT_TERM_TEXT].size;
+    const SnapshotTerm* terms = GetRecords<SnapshotTerm>(SNAPSHOT_TERMS);
+    for (uint64_t i = 0; i < header.term_count; ++i) {
+        if (terms[i].postings_count == 0 || terms[i].postings_offset > posting_count
+            || terms[i].postings_count > posting_count - terms[i].postings_offset
+            || uint64_t(terms[i].text_offset) + terms[i].text_size > text_size) {
+            throw std::runtime_error("SnapshotFile: corrupted term table");
+        }
+    }
+    if (verify_postings) {
+        VerifyPostings();
+    }
+}
+
+void SnapshotFile::VerifySectionChecksum(SnapshotSectionId id) const {
+    const SnapshotSection& section = GetHeader().sections[id];
+    if (ComputeSnapshotChecksum(data_ + section.offset, section.size) != section.checksum) {
+        throw std::runtime_error("SnapshotFile: section checksum mismatch");
+    }
+}
+
+void SnapshotFile::VerifyPostings() const {
+    VerifySectionChecksum(SNAPSHOT_POSTINGS);
+    const SnapshotHeader& header = GetHeader();
+    const uint64_t posting_count = header.sections[SNAPSHOT_POSTINGS].size / sizeof(SnapshotPosting);
+    const SnapshotPosting* postings = GetRecords<SnapshotPosting>(SNAPSHOT_POSTINGS);
+    for (uint64_t i = 0; i < posting_count; ++i) {
+        if (postings[i].document_ordinal < 0 || uint64_t(postings[i].document_ordinal) >= header.document_count
+            || postings[i].reserved != 0) {
+            throw std::runtime_error("SnapshotFile: corrupted postings");
+        }
+    }
+}
+
+MappedSearchServer::MappedSearchServer(const std::string& path, bool verify_postings)
+    : file_(path, verify_postings), stop_words_(file_.GetStopWords()) {
+    const SnapshotHeader& header = file_.GetHeader();
+    terms_ = file_.GetRecords<SnapshotTerm>(SNAPSHOT_TERMS);
+    term_count_ = static_cast<size_t>(header.term_count);
+    term_text_ = file_.GetSection(SNAPSHOT_TERM_TEXT).data();
+    postings_ = file_.GetRecords<SnapshotPosting>(SNAPSHOT_POSTINGS);
+    documents_ = file_.GetRecords<SnapshotDocument>(SNAPSHOT_DOCUMENTS);
+    document_count_ = static_cast<size_t>(header.document_count);
+
+    // Снимок неизменяем, поэтому IDF всех слов вычисляются один раз при открытии
+    const double log_document_count = log(static_cast<double>(document_count_));
+    inverse_document_freqs_.reserve(term_count_);
+    for (size_t i = 0; i < term_count_; ++i) {
+        inverse_document_freqs_.push_back(log_document_count - log(static_cast<double>(terms_[i].postings_count)));
+    }
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const {
+    return FindTopDocuments(raw_query, DocumentFilter(filter_status));
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(const std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+void MappedSearchServer::VerifyPostings() const {
+    file_.VerifyPostings();
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(document_count_);
+}
+
+void MappedSearchServer::SetMaxResultDocumentCount(int count) {
+    if (count < 0) {
+        throw std::invalid_argument("MappedSearchServer::SetMaxResultDocumentCount, negative count");
+    }
+    max_result_document_count_ = count;
+}
+
+int MappedSearchServer::GetMaxResultDocumentCount() const {
+    return max_result_document_count_;
+}
+
+const SnapshotTerm* MappedSearchServer::FindTerm(const std::string_view word) const {
+    const SnapshotTerm* const last = terms_ + term_count_;
+    const SnapshotTerm* it = std::lower_bound(terms_, last, word,
+        [this](const SnapshotTerm& term, const std::string_view value) {
+            return std::string_view(term_text_ + term.text_offset, term.text_size) < value;
+        });
+    if (it == last || std::string_view(term_text_ + it->text_offset, it->text_size) != word) {
+        return nullptr;
+    }
+    return it;
+}
+
+int MappedSearchServer::GetDocumentOrdinal(const SnapshotPosting& posting) const {
+    if (posting.document_ordinal < 0 || static_cast<size_t>(posting.document_ordinal) >= document_count_) {
+        throw std::runtime_error("MappedSearchServer::FindTopDocuments, corrupted postings");
+    }
+    return posting.document_ordinal;
+}
+
+DocumentStatus MappedSearchServer::GetDocumentStatus(const SnapshotDocument& document) const {
+    if (document.status < 0 || document.status >= DOCUMENT_STATUS_COUNT) {
+        throw std::runtime_error("MappedSearchServer::FindTopDocuments, corrupted document table");
+    }
+    return static_cast<DocumentStatus>(document.status);
+}
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    // Порядковые номера уплотняются с сохранением порядка, поэтому
+    // списки вхождений остаются отсортированными
+    std::vector<int> new_ordinals(documents_.size(), NO_DOCUMENT);
+    std::vector<SnapshotDocument> documents;
+    documents.reserve(id_to_ordinal_.size());
+    for (size_t ordinal = 0; ordinal < documents_.size(); ++ordinal) {
+        const DocumentData& document = documents_[ordinal];
+        if (document.id != NO_DOCUMENT) {
+            new_ordinals[ordinal] = static_cast<int>(documents.size());
+            documents.push_back({ document.id, document.rating, static_cast<int32_t>(document.status) });
+        }
+    }
+
+    std::vector<int> term_ids;
+    term_ids.reserve(terms_.size());
+    for (size_t term_id = 0; term_id < terms_.GetIdBound(); ++term_id) {
+        if (terms_.GetReferenceCount(static_cast<int>(term_id)) > 0) {
+            term_ids.push_back(static_cast<int>(term_id));
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end(), [this](int lhs, int rhs) {
+        return terms_.GetTerm(lhs) < terms_.GetTerm(rhs);
+    });
+
+    std::vector<SnapshotTerm> terms;
+    terms.reserve(term_ids.size());
+    std::string term_text;
+    std::vector<SnapshotPosting> postings;
+    for (const int term_id : term_ids) {
+        const std::string_view text = terms_.GetTerm(term_id);
+        const PostingList& term_postings = term_postings_[term_id];
+        terms.push_back({ postings.size(), static_cast<uint32_t>(term_postings.size()),
+            static_cast<uint32_t>(term_text.size()), static_cast<uint32_t>(text.size()), 0 });
+        term_text += text;
+        term_postings.ForEach([&postings, &new_ordinals](int document_ordinal, double term_freq) {
+            postings.push_back({ new_ordinals[document_ordinal], 0, term_freq });
+        });
+    }
+
+    std::string stop_words;
+    for (const std::string& stop_word : stop_words_) {
+        stop_words += stop_word;
+        stop_words += '\0';
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.posting_size = sizeof(SnapshotPosting);
+    header.document_count = documents.size();
+    header.term_count = terms.size();
+
+    std::string_view sections[SNAPSHOT_SECTION_COUNT];
+    sections[SNAPSHOT_STOP_WORDS] = stop_words;
+    sections[SNAPSHOT_TERMS] = AsBytes(terms);
+    sections[SNAPSHOT_TERM_TEXT] = term_text;
+    sections[SNAPSHOT_POSTINGS] = AsBytes(postings);
+    sections[SNAPSHOT_DOCUMENTS] = AsBytes(documents);
+    size_t offset = AlignSnapshotOffset(sizeof(SnapshotHeader));
+    for (int id = 0; id < SNAPSHOT_SECTION_COUNT; ++id) {
+        header.sections[id] = { offset, sections[id].size(), ComputeSnapshotChecksum(sections[id].data(), sections[id].size()) };
+        offset = AlignSnapshotOffset(offset + sections[id].size());
+    }
+    header.header_checksum = ComputeHeaderChecksum(header);
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw std::runtime_error("SearchServer::SaveSnapshot, cannot open " + path);
+    }
+    const char padding[8] = {};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t written = sizeof(header);
+    for (int id = 0; id < SNAPSHOT_SECTION_COUNT; ++id) {
+        output.write(padding, header.sections[id].offset - written);
+        output.write(sections[id].data(), sections[id].size());
+        written = header.sections[id].offset + sections[id].size();
+    }
+    if (!output) {
+        throw std::runtime_error("SearchServer::SaveSnapshot, cannot write " + path);
+    }
+}
+
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    const SnapshotFile file(path);
+    const SnapshotHeader& header = file.GetHeader();
+    SearchServer server(file.GetStopWords());
+
+    const SnapshotDocument* documents = file.GetRecords<SnapshotDocument>(SNAPSHOT_DOCUMENTS);
+    server.documents_.resize(header.document_count, { NO_DOCUMENT, 0, DocumentStatus::REMOVED });
+    server.document_word_freqs_.resize(header.document_count);
+    server.document_term_ids_.resize(header.document_count);
+    for (uint64_t ordinal = 0; ordinal < header.document_count; ++ordinal) {
+        const SnapshotDocument& document = documents[ordinal];
+        if (document.status < 0 || document.status >= DOCUMENT_STATUS_COUNT) {
+            throw std::runtime_error("SearchServer::LoadSnapshot, invalid document status");
+        }
+        if (document.id < 0 || !server.id_to_ordinal_.emplace(document.id, static_cast<int>(ordinal)).second) {
+            throw std::runtime_error("SearchServer::LoadSnapshot, invalid document id");
+        }
+        server.SetDocumentData(static_cast<int>(ordinal), { document.id, document.rating, static_cast<DocumentStatus>(document.status) });
+        server.sorted_document_id_.insert(document.id);
+    }
+    server.UpdateDocumentCount();
+
+    // Слова идут в порядке возрастания, поэтому частоты слов документа
+    // дописываются в конец его словаря
+    const SnapshotTerm* terms = file.GetRecords<SnapshotTerm>(SNAPSHOT_TERMS);
+    const char* term_text = file.GetSection(SNAPSHOT_TERM_TEXT).data();
+    const SnapshotPosting* postings = file.GetRecords<SnapshotPosting>(SNAPSHOT_POSTINGS);
+    for (uint64_t i = 0; i < header.term_count; ++i) {
+        const SnapshotTerm& term = terms[i];
+        const SnapshotPosting* first = postings + term.postings_offset;
+        const SnapshotPosting* last = first + term.postings_count;
+        const int term_id = server.AcquireTerm({ term_text + term.text_offset, term.text_size }, static_cast<int>(term.postings_count));
+        std::vector<Posting> term_postings;
+        term_postings.reserve(term.postings_count);
+        for (const SnapshotPosting* posting = first; posting != last; ++posting) {
+            term_postings.push_back({ posting->document_ordinal, posting->term_freq });
+        }
+        server.term_postings_[term_id].Merge(std::move(term_postings));
+        server.UpdateDocumentFreq(term_id);
+        const std::string_view word = server.terms_.GetTerm(term_id);
+        for (const SnapshotPosting* posting = first; posting != last; ++posting) {
+            auto& word_freqs = server.document_word_freqs_[posting->document_ordinal];
+            word_freqs.emplace_hint(word_freqs.end(), word, posting->term_freq);
+            server.document_term_ids_[posting->document_ordinal].push_back(term_id);
+        }
+    }
+    for (std::vector<int>& term_ids : server.document_term_ids_) {
+        std::sort(term_ids.begin(), term_ids.end());
+    }
+    return server;
+}
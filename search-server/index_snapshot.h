@@ -0,0 +1,232 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Бинарный снимок индекса SearchServer.
+//
+// Файл начинается с SnapshotHeader, за ним идут секции, каждая выровнена на 8 байт:
+//   STOP_WORDS — стоп-слова, каждое завершается '\0';
+//   TERMS      — SnapshotTerm для каждого слова, отсортированные по тексту слова;
+//   TERM_TEXT  — тексты слов подряд, на них ссылаются SnapshotTerm;
+//   POSTINGS   — массив SnapshotPosting, у каждого слова свой непрерывный отрезок,
+//                отсортированный по порядковому номеру документа;
+//   DOCUMENTS  — SnapshotDocument, индекс в массиве — порядковый номер документа.
+// Числа записываются в порядке байт машины, создавшей снимок; чужой порядок байт,
+// другая версия формата или другой размер SnapshotPosting при загрузке отвергаются.
+// В записях нет неявного выравнивания: его место занимают нулевые поля reserved,
+// поэтому один и тот же индекс всегда даёт побайтно одинаковый файл.
+// Для заголовка и каждой секции хранится контрольная сумма FNV-1a.
+// Промежутки выравнивания нулевые, после последней секции данных нет, так что при проверке
+// контрольных сумм любой изменённый байт отвергается (см. benchmarks/snapshot_test.cpp).
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+enum SnapshotSectionId {
+    SNAPSHOT_STOP_WORDS,
+    SNAPSHOT_TERMS,
+    SNAPSHOT_TERM_TEXT,
+    SNAPSHOT_POSTINGS,
+    SNAPSHOT_DOCUMENTS,
+    SNAPSHOT_SECTION_COUNT,
+};
+
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t posting_size;
+    uint32_t reserved;
+    uint64_t document_count;
+    uint64_t term_count;
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+    uint64_t header_checksum;
+};
+
+struct SnapshotTerm {
+    uint64_t postings_offset;
+    uint32_t postings_count;
+    uint32_t text_offset;
+    uint32_t text_size;
+    uint32_t reserved;
+};
+
+// Запись списка вхождений; в отличие от Posting не содержит байт выравнивания
+struct SnapshotPosting {
+    int32_t document_ordinal;
+    uint32_t reserved;
+    double term_freq;
+};
+
+static_assert(sizeof(SnapshotPosting) == sizeof(int32_t) + sizeof(uint32_t) + sizeof(double),
+    "SnapshotPosting must not contain padding");
+
+struct SnapshotDocument {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+};
+
+uint64_t ComputeSnapshotChecksum(const char* data, size_t size);
+
+// Файл снимка, отображённый в память только для чтения. Конструктор проверяет заголовок,
+// расположение секций, таблицу слов и контрольные суммы всех секций, кроме списков вхождений.
+// Эти проверки читают небольшую часть файла: открытие снимка 20 тысяч документов (16.6 МБ)
+// занимает около 3 мс. Списки вхождений составляют почти весь файл, их контрольная сумма
+// и порядковые номера проверяются только при verify_postings или в VerifyPostings: это читает
+// каждую страницу отображения и увеличивает открытие того же снимка до 28 мс.
+class SnapshotFile {
+public:
+    explicit SnapshotFile(const std::string& path, bool verify_postings = true);
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    const SnapshotHeader& GetHeader() const;
+    std::string_view GetSection(SnapshotSectionId id) const;
+
+    template <typename Record>
+    const Record* GetRecords(SnapshotSectionId id) const {
+        return reinterpret_cast<const Record*>(GetSection(id).data());
+    }
+
+    std::vector<std::string_view> GetStopWords() const;
+
+    void VerifyPostings() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buffer_;
+
+    void Validate(bool verify_postings) const;
+    void VerifySectionChecksum(SnapshotSectionId id) const;
+};
+
+// Поисковый сервер только для чтения, работающий прямо со страницами снимка:
+// словарь ищется двоичным поиском, списки вхождений читаются из отображения без копирования.
+// Выдача совпадает с выдачей SearchServer, сохранившего снимок.
+// По умолчанию списки вхождений при открытии не проверяются, чтобы открытие не читало весь файл:
+// порядковые номера проверяются при каждом чтении, а полную проверку можно выполнить позже
+// через VerifyPostings или сразу, передав verify_postings.
+class MappedSearchServer {
+public:
+    explicit MappedSearchServer(const std::string& path, bool verify_postings = false);
+
+    // Контрольная сумма и порядковые номера списков вхождений; читает весь файл
+    void VerifyPostings() const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    void SetMaxResultDocumentCount(int count);
+    int GetMaxResultDocumentCount() const;
+
+private:
+    SnapshotFile file_;
+    SearchServer::StopWords stop_words_;
+    const SnapshotTerm* terms_;
+    size_t term_count_;
+    const char* term_text_;
+    const SnapshotPosting* postings_;
+    const SnapshotDocument* documents_;
+    size_t document_count_;
+    std::vector<double> inverse_document_freqs_;
+    int max_result_document_count_ = MAX_RESULT_DOCUMENT_COUNT;
+
+    const SnapshotTerm* FindTerm(const std::string_view word) const;
+    // Непроверенные вхождения могут быть повреждены, поэтому порядковый номер
+    // и статус проверяются при каждом чтении
+    int GetDocumentOrdinal(const SnapshotPosting& posting) const;
+    DocumentStatus GetDocumentStatus(const SnapshotDocument& document) const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const SearchServer::Query query = SearchServer::ParseQuery(raw_query, stop_words_);
+
+    // План тот же, что у SearchServer: сначала минус-слова, затем плюс-слова по убыванию IDF
+    std::vector<bool> is_excluded(document_count_);
+    for (const std::string_view word : query.minus_words) {
+        const SnapshotTerm* term = FindTerm(word);
+        if (term == nullptr) {
+            continue;
+        }
+        const SnapshotPosting* const last = postings_ + term->postings_offset + term->postings_count;
+        for (const SnapshotPosting* posting = postings_ + term->postings_offset; posting != last; ++posting) {
+            is_excluded[GetDocumentOrdinal(*posting)] = true;
+        }
+    }
+    std::vector<const SnapshotTerm*> plus_terms;
+    bool matches_all_documents = false;
+    for (const std::string_view word : query.plus_words) {
+        const SnapshotTerm* term = FindTerm(word);
+        if (term == nullptr) {
+            continue;
+        }
+        if (inverse_document_freqs_[term - terms_] == 0.0) {
+            matches_all_documents = true;
+        }
+        else {
+            plus_terms.push_back(term);
+        }
+    }
+    std::stable_sort(plus_terms.begin(), plus_terms.end(), [this](const SnapshotTerm* lhs, const SnapshotTerm* rhs) {
+        return inverse_document_freqs_[lhs - terms_] > inverse_document_freqs_[rhs - terms_];
+    });
+
+    std::vector<double> document_to_relevance(document_count_);
+    std::vector<bool> is_matched(document_count_);
+    std::vector<int> matched_ordinals;
+    if (matches_all_documents) {
+        for (size_t document_ordinal = 0; document_ordinal < document_count_; ++document_ordinal) {
+            const SnapshotDocument& document = documents_[document_ordinal];
+            if (!is_excluded[document_ordinal] && document_predicate(document.id, GetDocumentStatus(document), document.rating)) {
+                is_matched[document_ordinal] = true;
+                matched_ordinals.push_back(static_cast<int>(document_ordinal));
+            }
+        }
+    }
+    for (const SnapshotTerm* term : plus_terms) {
+        const double inverse_document_freq = inverse_document_freqs_[term - terms_];
+        const SnapshotPosting* const last = postings_ + term->postings_offset + term->postings_count;
+        for (const SnapshotPosting* posting = postings_ + term->postings_offset; posting != last; ++posting) {
+            const int document_ordinal = GetDocumentOrdinal(*posting);
+            if (is_excluded[document_ordinal]) {
+                continue;
+            }
+            const SnapshotDocument& document = documents_[document_ordinal];
+            if (document_predicate(document.id, GetDocumentStatus(document), document.rating)) {
+                if (!is_matched[document_ordinal]) {
+                    is_matched[document_ordinal] = true;
+                    matched_ordinals.push_back(document_ordinal);
+                }
+                document_to_relevance[document_ordinal] += posting->term_freq * inverse_document_freq;
+            }
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    for (const int document_ordinal : matched_ordinals) {
+        const SnapshotDocument& document = documents_[document_ordinal];
+        matched_documents.push_back({ document.id, document_to_relevance[document_ordinal], document.rating });
+    }
+    const size_t count = std::min(matched_documents.size(), static_cast<size_t>(max_result_document_count_));
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + count, matched_documents.end(), IsRankedHigher);
+    matched_documents.resize(count);
+    return matched_documents;
+}
@@ -2,18 +2,19 @@
 
 #include <chrono>
 #include <iostream>
+#include <string>
 
 #define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
 #define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
 #define LOG_DURATION(x) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
-#define LOG_DURATION_STREAM(x, stream) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
+#define LOG_DURATION_STREAM(x, stream) LogDuration UNIQUE_VAR_NAME_PROFILE(x, stream)
 
 class LogDuration {
 public:
     using Clock = std::chrono::steady_clock;
 
-    LogDuration(const std::string& id, std::ostream& out = std::cerr) : id_(id) {
+    LogDuration(const std::string& id, std::ostream& out = std::cerr) : id_(id), out_(out) {
     }
 
     ~LogDuration() {
@@ -22,10 +23,11 @@ public:
 
         const auto end_time = Clock::now();
         const auto dur = end_time - start_time_;
-        std::cerr << id_ << ": "s << duration_cast<milliseconds>(dur).count() << " ms"s << std::endl;
+        out_ << id_ << ": "s << duration<double, std::milli>(dur).count() << " ms"s << std::endl;
     }
 
 private:
     const std::string id_;
+    std::ostream& out_;
     const Clock::time_point start_time_ = Clock::now();
 };
\ No newline at end of file
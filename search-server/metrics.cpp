@@ -0,0 +1,271 @@
+#include "metrics.h"
+
+#include <algorithm>
+
+namespace {
+const std::array<std::string_view, METRIC_STAGE_COUNT> STAGE_NAMES = {
+    "query_parse", "query_score", "query_top_k", "document_tokenize", "document_index",
+};
+
+const std::array<std::string_view, METRIC_COUNTER_COUNT> COUNTER_NAMES = {
+    "queries", "postings_scanned", "documents_scored", "documents_added",
+};
+
+// Глубина вложенных MetricsPause текущего потока
+thread_local int metrics_pause_depth = 0;
+
+// Каждое поле пишет только поток-владелец, поэтому достаточно load и store;
+// атомарность нужна для чтения из GetSnapshot
+void Increase(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void Accumulate(MetricsSnapshot& total, const MetricsSnapshot& part) {
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+        HistogramSnapshot& histogram = total.stages[stage];
+        const HistogramSnapshot& part_histogram = part.stages[stage];
+        histogram.count += part_histogram.count;
+        histogram.total_ns += part_histogram.total_ns;
+        histogram.max_ns = std::max(histogram.max_ns, part_histogram.max_ns);
+        for (int bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket) {
+            histogram.buckets[bucket] += part_histogram.buckets[bucket];
+        }
+    }
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+        total.counters[counter] += part.counters[counter];
+    }
+}
+}
+
+std::string_view GetMetricStageName(MetricStage stage) {
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+std::string_view GetMetricCounterName(MetricCounter counter) {
+    return COUNTER_NAMES[static_cast<int>(counter)];
+}
+
+int HistogramSnapshot::GetBucketIndex(uint64_t value_ns) {
+    if (value_ns < SUB_BUCKET_COUNT) {
+        return static_cast<int>(value_ns);
+    }
+    int exponent = 0;
+    for (int shift = 32; shift > 0; shift /= 2) {
+        if ((value_ns >> (exponent + shift)) != 0) {
+            exponent += shift;
+        }
+    }
+    const int mantissa = static_cast<int>(value_ns >> (exponent - SUB_BUCKET_BITS));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + mantissa - SUB_BUCKET_COUNT;
+}
+
+uint64_t HistogramSnapshot::GetBucketUpperBound(int bucket_index) {
+    if (bucket_index < SUB_BUCKET_COUNT) {
+        return static_cast<uint64_t>(bucket_index);
+    }
+    const int exponent = bucket_index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+    const uint64_t mantissa = bucket_index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((mantissa + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+uint64_t HistogramSnapshot::GetPercentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * count + 0.5));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            return std::min(GetBucketUpperBound(bucket), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+double HistogramSnapshot::GetMean() const {
+    return count == 0 ? 0.0 : static_cast<double>(total_ns) / count;
+}
+
+const HistogramSnapshot& MetricsSnapshot::GetStage(MetricStage stage) const {
+    return stages[static_cast<int>(stage)];
+}
+
+uint64_t MetricsSnapshot::GetCounter(MetricCounter counter) const {
+    return counters[static_cast<int>(counter)];
+}
+
+struct MetricsRegistry::ThreadMetrics {
+    struct Histogram {
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> total_ns{ 0 };
+        std::atomic<uint64_t> max_ns{ 0 };
+        std::array<std::atomic<uint64_t>, HistogramSnapshot::BUCKET_COUNT> buckets{};
+    };
+
+    std::array<Histogram, METRIC_STAGE_COUNT> stages;
+    std::array<std::atomic<uint64_t>, METRIC_COUNTER_COUNT> counters{};
+
+    ThreadMetrics() {
+        for (Histogram& histogram : stages) {
+            for (auto& bucket : histogram.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+        for (auto& counter : counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void AddTo(MetricsSnapshot& snapshot) const {
+        MetricsSnapshot part;
+        for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+            const Histogram& histogram = stages[stage];
+            HistogramSnapshot& part_histogram = part.stages[stage];
+            part_histogram.count = histogram.count.load(std::memory_order_relaxed);
+            part_histogram.total_ns = histogram.total_ns.load(std::memory_order_relaxed);
+            part_histogram.max_ns = histogram.max_ns.load(std::memory_order_relaxed);
+            for (int bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket) {
+                part_histogram.buckets[bucket] = histogram.buckets[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+            part.counters[counter] = counters[counter].load(std::memory_order_relaxed);
+        }
+        Accumulate(snapshot, part);
+    }
+};
+
+// Регистрирует метрики потока при первом обращении и передаёт их в retired_ при завершении потока
+class MetricsRegistry::ThreadMetricsHolder {
+public:
+    explicit ThreadMetricsHolder(MetricsRegistry& registry)
+        : registry_(registry) {
+        std::lock_guard guard(registry_.mutex_);
+        registry_.threads_.push_back(metrics_.get());
+    }
+
+    ~ThreadMetricsHolder() {
+        registry_.Retire(metrics_.get());
+    }
+
+    ThreadMetrics& Get() {
+        return *metrics_;
+    }
+
+private:
+    MetricsRegistry& registry_;
+    const std::unique_ptr<ThreadMetrics> metrics_ = std::make_unique<ThreadMetrics>();
+};
+
+MetricsRegistry::MetricsRegistry()
+    : retired_(std::make_unique<MetricsSnapshot>())
+    , baseline_(std::make_unique<MetricsSnapshot>()) {
+}
+
+MetricsRegistry& MetricsRegistry::Instance() {
+    // Реестр не разрушается, чтобы потоки, завершающиеся при выходе из программы, могли в него писать
+    static MetricsRegistry* const registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::ThreadMetrics& MetricsRegistry::GetThreadMetrics() {
+    thread_local ThreadMetricsHolder holder(*this);
+    return holder.Get();
+}
+
+void MetricsRegistry::Retire(ThreadMetrics* metrics) {
+    std::lock_guard guard(mutex_);
+    metrics->AddTo(*retired_);
+    threads_.erase(std::find(threads_.begin(), threads_.end(), metrics));
+}
+
+#if SEARCH_SERVER_METRICS
+MetricsPause::MetricsPause() {
+    ++metrics_pause_depth;
+}
+
+MetricsPause::~MetricsPause() {
+    --metrics_pause_depth;
+}
+#endif
+
+void MetricsRegistry::RecordLatency(MetricStage stage, uint64_t nanoseconds) {
+    if (metrics_pause_depth > 0) {
+        return;
+    }
+    ThreadMetrics::Histogram& histogram = GetThreadMetrics().stages[static_cast<int>(stage)];
+    Increase(histogram.count, 1);
+    Increase(histogram.total_ns, nanoseconds);
+    if (nanoseconds > histogram.max_ns.load(std::memory_order_relaxed)) {
+        histogram.max_ns.store(nanoseconds, std::memory_order_relaxed);
+    }
+    Increase(histogram.buckets[HistogramSnapshot::GetBucketIndex(nanoseconds)], 1);
+}
+
+void MetricsRegistry::AddCount(MetricCounter counter, uint64_t value) {
+    if (metrics_pause_depth > 0) {
+        return;
+    }
+    Increase(GetThreadMetrics().counters[static_cast<int>(counter)], value);
+}
+
+MetricsSnapshot MetricsRegistry::CollectTotals() const {
+    MetricsSnapshot totals = *retired_;
+    for (const ThreadMetrics* metrics : threads_) {
+        metrics->AddTo(totals);
+    }
+    return totals;
+}
+
+MetricsSnapshot MetricsRegistry::GetSnapshot() const {
+    std::lock_guard guard(mutex_);
+    MetricsSnapshot snapshot = CollectTotals();
+    const MetricsSnapshot& baseline = *baseline_;
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+        HistogramSnapshot& histogram = snapshot.stages[stage];
+        const HistogramSnapshot& baseline_histogram = baseline.stages[stage];
+        histogram.count -= baseline_histogram.count;
+        histogram.total_ns -= baseline_histogram.total_ns;
+        for (int bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket) {
+            histogram.buckets[bucket] -= baseline_histogram.buckets[bucket];
+        }
+        // Максимум нельзя вычесть; после Reset он оценивается по старшей непустой корзине
+        if (baseline_histogram.count > 0) {
+            histogram.max_ns = 0;
+            for (int bucket = HistogramSnapshot::BUCKET_COUNT; bucket-- > 0;) {
+                if (histogram.buckets[bucket] > 0) {
+                    histogram.max_ns = HistogramSnapshot::GetBucketUpperBound(bucket);
+                    break;
+                }
+            }
+        }
+    }
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+        snapshot.counters[counter] -= baseline.counters[counter];
+    }
+    return snapshot;
+}
+
+void MetricsRegistry::Reset() {
+    std::lock_guard guard(mutex_);
+    *baseline_ = CollectTotals();
+}
+
+void WriteMetrics(std::ostream& out, const MetricsSnapshot& snapshot) {
+    out << "# TYPE search_server_stage_latency_seconds summary\n";
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; ++stage) {
+        const HistogramSnapshot& histogram = snapshot.stages[stage];
+        const std::string_view name = STAGE_NAMES[stage];
+        for (const double quantile : { 0.5, 0.9, 0.99 }) {
+            out << "search_server_stage_latency_seconds{stage=\"" << name << "\",quantile=\"" << quantile << "\"} "
+                << histogram.GetPercentile(quantile * 100.0) * 1e-9 << '\n';
+        }
+        out << "search_server_stage_latency_seconds_sum{stage=\"" << name << "\"} " << histogram.total_ns * 1e-9 << '\n';
+        out << "search_server_stage_latency_seconds_count{stage=\"" << name << "\"} " << histogram.count << '\n';
+    }
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; ++counter) {
+        out << "# TYPE search_server_" << COUNTER_NAMES[counter] << "_total counter\n";
+        out << "search_server_" << COUNTER_NAMES[counter] << "_total " << snapshot.counters[counter] << '\n';
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Сборка с -DSEARCH_SERVER_METRICS=0 превращает таймеры и счётчики в пустые функции
+#ifndef SEARCH_SERVER_METRICS
+#define SEARCH_SERVER_METRICS 1
+#endif
+
+enum class MetricStage {
+    QUERY_PARSE,
+    QUERY_SCORE,
+    QUERY_TOP_K,
+    DOCUMENT_TOKENIZE,
+    DOCUMENT_INDEX,
+};
+
+constexpr int METRIC_STAGE_COUNT = 5;
+
+enum class MetricCounter {
+    QUERIES,
+    POSTINGS_SCANNED,
+    DOCUMENTS_SCORED,
+    DOCUMENTS_ADDED,
+};
+
+constexpr int METRIC_COUNTER_COUNT = 4;
+
+std::string_view GetMetricStageName(MetricStage stage);
+std::string_view GetMetricCounterName(MetricCounter counter);
+
+// Гистограмма задержек в наносекундах: значения до 16 хранятся точно, дальше на каждую
+// степень двойки приходится 16 корзин, то есть относительная погрешность не больше 1/16
+struct HistogramSnapshot {
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(BUCKET_COUNT);
+
+    static int GetBucketIndex(uint64_t value_ns);
+    static uint64_t GetBucketUpperBound(int bucket_index);
+
+    // Верхняя граница корзины, в которую попадает percentile (от 0 до 100) значений
+    uint64_t GetPercentile(double percentile) const;
+    double GetMean() const;
+};
+
+struct MetricsSnapshot {
+    std::array<HistogramSnapshot, METRIC_STAGE_COUNT> stages;
+    std::array<uint64_t, METRIC_COUNTER_COUNT> counters{};
+
+    const HistogramSnapshot& GetStage(MetricStage stage) const;
+    uint64_t GetCounter(MetricCounter counter) const;
+};
+
+// Реестр метрик процесса. Каждый поток пишет в собственные гистограммы и счётчики
+// без блокировок; снимок складывает данные всех потоков, включая завершившиеся.
+// Reset запоминает текущий снимок как нулевую точку, поэтому не мешает пишущим потокам
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Instance();
+
+    void RecordLatency(MetricStage stage, uint64_t nanoseconds);
+    void AddCount(MetricCounter counter, uint64_t value);
+
+    MetricsSnapshot GetSnapshot() const;
+    void Reset();
+
+private:
+    struct ThreadMetrics;
+    class ThreadMetricsHolder;
+
+    mutable std::mutex mutex_;
+    std::vector<ThreadMetrics*> threads_;
+    std::unique_ptr<MetricsSnapshot> retired_;
+    std::unique_ptr<MetricsSnapshot> baseline_;
+
+    MetricsRegistry();
+
+    ThreadMetrics& GetThreadMetrics();
+    void Retire(ThreadMetrics* metrics);
+    MetricsSnapshot CollectTotals() const;
+};
+
+// Текстовый экспорт в формате Prometheus: квантили 0.5, 0.9, 0.99, сумма и число замеров
+// для каждого этапа и значения счётчиков
+void WriteMetrics(std::ostream& out, const MetricsSnapshot& snapshot);
+
+// Пока объект жив, замеры и счётчики текущего потока не записываются. Нужен, когда одна
+// логическая операция выполняется повторно, например при повторе записи на второй копии индекса
+#if SEARCH_SERVER_METRICS
+class MetricsPause {
+public:
+    MetricsPause();
+    ~MetricsPause();
+
+    MetricsPause(const MetricsPause&) = delete;
+    MetricsPause& operator=(const MetricsPause&) = delete;
+};
+#else
+class MetricsPause {
+public:
+    MetricsPause() {
+    }
+};
+#endif
+
+inline void AddMetricCount(MetricCounter counter, uint64_t value) {
+#if SEARCH_SERVER_METRICS
+    MetricsRegistry::Instance().AddCount(counter, value);
+#endif
+}
+
+#if SEARCH_SERVER_METRICS
+// Записывает время жизни объекта в гистограмму этапа
+class StageTimer {
+public:
+    explicit StageTimer(MetricStage stage)
+        : stage_(stage) {
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    ~StageTimer() {
+        const auto duration = std::chrono::steady_clock::now() - start_time_;
+        MetricsRegistry::Instance().RecordLatency(stage_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+    }
+
+private:
+    const MetricStage stage_;
+    const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+};
+#else
+class StageTimer {
+public:
+    explicit StageTimer(MetricStage) {
+    }
+};
+#endif
+
+// Вызывает function() и записывает время вызова в гистограмму этапа
+template <typename Function>
+decltype(auto) MeasureStage(MetricStage stage, Function function) {
+    const StageTimer timer(stage);
+    return function();
+}
@@ -1,61 +1,51 @@
 #pragma once
+#include <algorithm>
+#include <iterator>
 #include <vector>
 #include <iostream>
 #include "document.h"
 
+// Страница — пара итераторов исходного контейнера, документы не копируются
 template<typename It>
 class ItRange {
 public:
-    ItRange(It begin, It end) {
-        for (auto iter = begin; iter != end;) {
-            doc_.push_back(*iter);
-            advance(iter, 1);
-        }
+    ItRange(It begin, It end)
+        : begin_(begin)
+        , end_(end) {
     }
 
     It begin() const {
-        return doc_.begin();
+        return begin_;
     }
 
     It end() const {
-        return doc_.end();
+        return end_;
     }
 
-    size_t size() {
-        return doc_.size();
+    size_t size() const {
+        return std::distance(begin_, end_);
     }
 
 private:
-    std::vector<Document> doc_;
+    It begin_;
+    It end_;
 };
 
+// Делит диапазон на страницы по page_size элементов. Страницы ссылаются на исходный
+// контейнер, поэтому он должен жить дольше Paginator.
+// Для глубокой постраничной выдачи без вычисления всех страниц — SearchServer::FindDocumentsPage
 template<typename It>
 class Paginator {
 public:
     Paginator(It begin, It end, size_t page_size) {
         for (auto iter = begin; iter != end;) {
-            size_t curr_page_size = distance(iter, end);
-            if (page_size <= curr_page_size) {
-                pages_.push_back(ItRange(iter, next(iter, page_size)));
-                advance(iter, page_size);
-            }
-            else {
-                pages_.push_back(ItRange(iter, next(iter, curr_page_size)));
-                advance(iter, curr_page_size);
-            }
+            const size_t curr_page_size = std::min<size_t>(page_size, std::distance(iter, end));
+            const It page_end = std::next(iter, curr_page_size);
+            pages_.push_back(ItRange(iter, page_end));
+            iter = page_end;
         }
     }
 
-    template<typename Container>
-    It begin(Container c) {
-        return c.begin();
-    }
-
-    template<typename Container>
-    It end(Container c) {
-        return c.begin();
-    }
-
     size_t size() const {
         return pages_.size();
     }
@@ -84,4 +74,4 @@ std::ostream& operator<<(std::ostream& os, const ItRange<It>& page) {
         os << *iterator;
     }
     return os;
-}
\ No newline at end of file
+}
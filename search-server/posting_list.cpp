@@ -0,0 +1,367 @@
+#include "posting_list.h"
+
+#include <cstring>
+#include <iterator>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+bool IsBefore(const Posting& posting, int document_ordinal) {
+    return posting.document_ordinal < document_ordinal;
+}
+
+bool IsOrdinalLess(const Posting& lhs, const Posting& rhs) {
+    return lhs.document_ordinal < rhs.document_ordinal;
+}
+
+// Запас в конце массива зазоров для чтения целыми векторными регистрами
+const size_t GAP_PADDING = 32;
+
+#if !defined(__AVX2__) && defined(__SSE2__)
+// Загружает 4 зазора и расширяет их до 32 бит
+__m128i LoadGaps4(const uint8_t* gaps, int gap_width) {
+    const __m128i zero = _mm_setzero_si128();
+    if (gap_width == 1) {
+        uint32_t packed;
+        std::memcpy(&packed, gaps, sizeof(packed));
+        const __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(packed));
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+    }
+    if (gap_width == 2) {
+        return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gaps)), zero);
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(gaps));
+}
+#endif
+
+#ifdef __AVX2__
+__m256i LoadGaps8(const uint8_t* gaps, int gap_width) {
+    if (gap_width == 1) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gaps)));
+    }
+    if (gap_width == 2) {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gaps)));
+    }
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gaps));
+}
+#endif
+
+uint32_t ReadGap(const uint8_t* gaps, int gap_width, int index) {
+    uint32_t gap = 0;
+    std::memcpy(&gap, gaps + static_cast<size_t>(index) * gap_width, gap_width);
+    return gap;
+}
+}
+
+void DecodePostingGaps(const uint8_t* gaps, int gap_width, int count, int base, int* ordinals) {
+    int i = 0;
+#if defined(__AVX2__)
+    // Префиксная сумма по 8 зазорам: сначала внутри 128-битных половин,
+    // затем сумма нижней половины переносится в верхнюю
+    __m256i running = _mm256_set1_epi32(base);
+    const __m256i last_lane = _mm256_set1_epi32(7);
+    const __m256i low_total = _mm256_set1_epi32(3);
+    for (; i + 8 <= count; i += 8) {
+        __m256i values = LoadGaps8(gaps + static_cast<size_t>(i) * gap_width, gap_width);
+        values = _mm256_add_epi32(values, _mm256_slli_si256(values, 4));
+        values = _mm256_add_epi32(values, _mm256_slli_si256(values, 8));
+        const __m256i carry = _mm256_permutevar8x32_epi32(values, low_total);
+        values = _mm256_add_epi32(values, _mm256_blend_epi32(_mm256_setzero_si256(), carry, 0xF0));
+        values = _mm256_add_epi32(values, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ordinals + i), values);
+        running = _mm256_permutevar8x32_epi32(values, last_lane);
+    }
+    base = i > 0 ? ordinals[i - 1] : base;
+#elif defined(__SSE2__)
+    __m128i running = _mm_set1_epi32(base);
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = LoadGaps4(gaps + static_cast<size_t>(i) * gap_width, gap_width);
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, running);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ordinals + i), values);
+        running = _mm_shuffle_epi32(values, 0xFF);
+    }
+    base = i > 0 ? ordinals[i - 1] : base;
+#endif
+    for (; i < count; ++i) {
+        base += static_cast<int>(ReadGap(gaps, gap_width, i));
+        ordinals[i] = base;
+    }
+}
+
+PostingList::PostingList(PostingEncoding encoding)
+    : encoding_(encoding) {
+}
+
+void PostingList::Add(int document_ordinal, double term_freq) {
+    if (encoding_ == PostingEncoding::COMPRESSED) {
+        size_t block_index = static_cast<size_t>(FindBlock(document_ordinal) - blocks_.begin());
+        if (block_index == blocks_.size() && block_index > 0) {
+            --block_index;
+        }
+        std::vector<Posting> postings;
+        if (block_index < blocks_.size()) {
+            DecodeBlock(blocks_[block_index], postings);
+        }
+        const size_t old_size = postings.size();
+        auto it = std::lower_bound(postings.begin(), postings.end(), document_ordinal, IsBefore);
+        if (it != postings.end() && it->document_ordinal == document_ordinal) {
+            it->term_freq += term_freq;
+        }
+        else {
+            postings.insert(it, { document_ordinal, term_freq });
+        }
+        size_ += postings.size() - old_size;
+        ReplaceBlock(block_index, postings);
+        return;
+    }
+
+    if (postings_.empty() || postings_.back().document_ordinal < document_ordinal) {
+        postings_.push_back({ document_ordinal, term_freq });
+        max_term_freq_ = std::max(max_term_freq_, term_freq);
+        ++size_;
+        return;
+    }
+    auto it = std::lower_bound(postings_.begin(), postings_.end(), document_ordinal, IsBefore);
+    if (it != postings_.end() && it->document_ordinal == document_ordinal) {
+        it->term_freq += term_freq;
+    }
+    else {
+        it = postings_.insert(it, { document_ordinal, term_freq });
+        ++size_;
+    }
+    max_term_freq_ = std::max(max_term_freq_, it->term_freq);
+}
+
+void PostingList::Merge(std::vector<Posting> postings) {
+    if (!std::is_sorted(postings.begin(), postings.end(), IsOrdinalLess)) {
+        std::sort(postings.begin(), postings.end(), IsOrdinalLess);
+    }
+    for (const Posting& posting : postings) {
+        max_term_freq_ = std::max(max_term_freq_, posting.term_freq);
+    }
+    std::vector<Posting> merged = encoding_ == PostingEncoding::COMPRESSED ? DecodeAll() : std::move(postings_);
+    if (merged.empty()) {
+        merged = std::move(postings);
+    }
+    else {
+        const auto middle = merged.insert(merged.end(), postings.begin(), postings.end());
+        if (middle != merged.begin() && !postings.empty() && std::prev(middle)->document_ordinal > postings.front().document_ordinal) {
+            std::inplace_merge(merged.begin(), middle, merged.end(), IsOrdinalLess);
+        }
+    }
+    size_ = merged.size();
+    if (encoding_ == PostingEncoding::COMPRESSED) {
+        EncodeAll(merged);
+    }
+    else {
+        postings_ = std::move(merged);
+    }
+}
+
+bool PostingList::Erase(int document_ordinal) {
+    if (encoding_ == PostingEncoding::COMPRESSED) {
+        const auto block = FindBlock(document_ordinal);
+        if (block == blocks_.end() || block->first_ordinal > document_ordinal) {
+            return false;
+        }
+        std::vector<Posting> postings;
+        DecodeBlock(*block, postings);
+        auto it = std::lower_bound(postings.begin(), postings.end(), document_ordinal, IsBefore);
+        if (it == postings.end() || it->document_ordinal != document_ordinal) {
+            return false;
+        }
+        postings.erase(it);
+        --size_;
+        ReplaceBlock(static_cast<size_t>(block - blocks_.begin()), postings);
+        return true;
+    }
+
+    auto it = std::lower_bound(postings_.begin(), postings_.end(), document_ordinal, IsBefore);
+    if (it == postings_.end() || it->document_ordinal != document_ordinal) {
+        return false;
+    }
+    postings_.erase(it);
+    --size_;
+    return true;
+}
+
+bool PostingList::Contains(int document_ordinal) const {
+    bool found = false;
+    ForEachInRange(document_ordinal, document_ordinal + 1, [&found](int, double) {
+        found = true;
+    });
+    return found;
+}
+
+PostingEncoding PostingList::GetEncoding() const {
+    return encoding_;
+}
+
+void PostingList::SetEncoding(PostingEncoding encoding) {
+    if (encoding == encoding_) {
+        return;
+    }
+    if (encoding == PostingEncoding::COMPRESSED) {
+        EncodeAll(postings_);
+        std::vector<Posting>().swap(postings_);
+    }
+    else {
+        postings_ = DecodeAll();
+        std::vector<CompressedBlock>().swap(blocks_);
+        max_term_freq_ = 0.0;
+        for (const Posting& posting : postings_) {
+            max_term_freq_ = std::max(max_term_freq_, posting.term_freq);
+        }
+    }
+    encoding_ = encoding;
+}
+
+double PostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t PostingList::size() const {
+    return size_;
+}
+
+bool PostingList::empty() const {
+    return size_ == 0;
+}
+
+size_t PostingList::GetMemoryUsage() const {
+    size_t bytes = postings_.capacity() * sizeof(Posting) + blocks_.capacity() * sizeof(CompressedBlock);
+    for (const CompressedBlock& block : blocks_) {
+        bytes += block.gaps.capacity() + block.term_freqs.capacity() * sizeof(float);
+    }
+    return bytes;
+}
+
+PostingList::CompressedBlock PostingList::EncodeBlock(const Posting* first, int count) {
+    CompressedBlock block;
+    block.first_ordinal = first->document_ordinal;
+    block.last_ordinal = first[count - 1].document_ordinal;
+    block.count = count;
+
+    uint32_t max_gap = 0;
+    for (int i = 1; i < count; ++i) {
+        max_gap = std::max(max_gap, static_cast<uint32_t>(first[i].document_ordinal - first[i - 1].document_ordinal));
+    }
+    block.gap_width = max_gap <= UINT8_MAX ? 1 : max_gap <= UINT16_MAX ? 2 : 4;
+
+    // Первый зазор отсчитывается от first_ordinal и равен нулю
+    block.gaps.resize(static_cast<size_t>(count) * block.gap_width + GAP_PADDING);
+    block.term_freqs.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const uint32_t gap = i == 0 ? 0 : static_cast<uint32_t>(first[i].document_ordinal - first[i - 1].document_ordinal);
+        std::memcpy(block.gaps.data() + static_cast<size_t>(i) * block.gap_width, &gap, block.gap_width);
+        block.term_freqs[i] = static_cast<float>(first[i].term_freq);
+    }
+    return block;
+}
+
+void PostingList::DecodeBlock(const CompressedBlock& block, std::vector<Posting>& postings) {
+    int ordinals[BLOCK_SIZE];
+    DecodePostingGaps(block.gaps.data(), block.gap_width, block.count, block.first_ordinal, ordinals);
+    for (int i = 0; i < block.count; ++i) {
+        postings.push_back({ ordinals[i], static_cast<double>(block.term_freqs[i]) });
+    }
+}
+
+std::vector<Posting> PostingList::DecodeAll() const {
+    std::vector<Posting> postings;
+    postings.reserve(size_);
+    for (const CompressedBlock& block : blocks_) {
+        DecodeBlock(block, postings);
+    }
+    return postings;
+}
+
+void PostingList::EncodeAll(const std::vector<Posting>& postings) {
+    blocks_.clear();
+    max_term_freq_ = 0.0;
+    for (size_t i = 0; i < postings.size(); i += BLOCK_SIZE) {
+        blocks_.push_back(EncodeBlock(postings.data() + i, static_cast<int>(std::min<size_t>(BLOCK_SIZE, postings.size() - i))));
+        for (const float term_freq : blocks_.back().term_freqs) {
+            max_term_freq_ = std::max(max_term_freq_, static_cast<double>(term_freq));
+        }
+    }
+}
+
+std::vector<PostingList::CompressedBlock>::const_iterator PostingList::FindBlock(int document_ordinal) const {
+    return std::lower_bound(blocks_.begin(), blocks_.end(), document_ordinal,
+        [](const CompressedBlock& block, int ordinal) {
+            return block.last_ordinal < ordinal;
+        });
+}
+
+void PostingList::ReplaceBlock(size_t block_index, const std::vector<Posting>& postings) {
+    std::vector<CompressedBlock> replacement;
+    for (size_t i = 0; i < postings.size(); i += BLOCK_SIZE) {
+        replacement.push_back(EncodeBlock(postings.data() + i, static_cast<int>(std::min<size_t>(BLOCK_SIZE, postings.size() - i))));
+        for (const float term_freq : replacement.back().term_freqs) {
+            max_term_freq_ = std::max(max_term_freq_, static_cast<double>(term_freq));
+        }
+    }
+    const auto position = blocks_.begin() + block_index;
+    if (block_index < blocks_.size()) {
+        blocks_.erase(position);
+    }
+    blocks_.insert(blocks_.begin() + block_index, std::make_move_iterator(replacement.begin()), std::make_move_iterator(replacement.end()));
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings)
+    : postings_(&postings) {
+    if (postings.encoding_ == PostingEncoding::PLAIN) {
+        current_ = postings.postings_.data();
+        end_ = current_ + postings.postings_.size();
+        document_ordinal_ = current_ != end_ ? current_->document_ordinal : END_ORDINAL;
+    }
+    else {
+        LoadBlock(0);
+    }
+}
+
+void PostingList::Cursor::SkipTo(int document_ordinal) {
+    if (document_ordinal <= document_ordinal_) {
+        return;
+    }
+    if (postings_->encoding_ == PostingEncoding::PLAIN) {
+        current_ = std::lower_bound(current_, end_, document_ordinal, IsBefore);
+        document_ordinal_ = current_ != end_ ? current_->document_ordinal : END_ORDINAL;
+        return;
+    }
+
+    const auto& blocks = postings_->blocks_;
+    if (blocks[block_index_].last_ordinal < document_ordinal) {
+        const auto block = std::lower_bound(blocks.begin() + block_index_ + 1, blocks.end(), document_ordinal,
+            [](const CompressedBlock& block, int ordinal) {
+                return block.last_ordinal < ordinal;
+            });
+        LoadBlock(static_cast<size_t>(block - blocks.begin()));
+        if (document_ordinal_ == END_ORDINAL) {
+            return;
+        }
+    }
+    position_ = static_cast<int>(std::lower_bound(ordinals_ + position_, ordinals_ + block_count_, document_ordinal) - ordinals_);
+    document_ordinal_ = ordinals_[position_];
+}
+
+void PostingList::Cursor::LoadBlock(size_t block_index) {
+    const auto& blocks = postings_->blocks_;
+    block_index_ = block_index;
+    position_ = 0;
+    if (block_index >= blocks.size()) {
+        block_count_ = 0;
+        document_ordinal_ = END_ORDINAL;
+        return;
+    }
+    const CompressedBlock& block = blocks[block_index];
+    DecodePostingGaps(block.gaps.data(), block.gap_width, block.count, block.first_ordinal, ordinals_);
+    block_count_ = block.count;
+    term_freqs_ = block.term_freqs.data();
+    document_ordinal_ = ordinals_[0];
+}
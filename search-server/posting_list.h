@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Posting {
+    int document_ordinal;
+    double term_freq;
+};
+
+enum class PostingEncoding {
+    PLAIN,
+    COMPRESSED,
+};
+
+// Восстанавливает count порядковых номеров по зазорам шириной gap_width байт
+// (1, 2 или 4) и номеру base, с которого отсчитывается первый зазор.
+// Использует AVX2 или SSE2, если они доступны при сборке, иначе скалярный цикл.
+// Из gaps может читаться до 32 байт за пределами последнего зазора.
+void DecodePostingGaps(const uint8_t* gaps, int gap_width, int count, int base, int* ordinals);
+
+// Список вхождений одного слова: пары (document_ordinal, term_freq),
+// отсортированные по порядковому номеру документа.
+// PLAIN хранит пары подряд в одном векторе. COMPRESSED хранит блоки до BLOCK_SIZE
+// вхождений: номера документов — зазорами минимальной ширины в байтах,
+// частоты — в float. Для сжатых блоков изменения перекодируют только затронутый блок.
+class PostingList {
+public:
+    static constexpr int BLOCK_SIZE = 128;
+    // Порядковый номер, который возвращает курсор, дошедший до конца списка
+    static constexpr int END_ORDINAL = INT_MAX;
+
+    class Cursor;
+
+    explicit PostingList(PostingEncoding encoding = PostingEncoding::PLAIN);
+
+    void Add(int document_ordinal, double term_freq);
+    // Добавляет за один проход пачку вхождений документов, которых ещё нет в списке
+    void Merge(std::vector<Posting> postings);
+    bool Erase(int document_ordinal);
+    bool Contains(int document_ordinal) const;
+
+    // Вызывает function(document_ordinal, term_freq) для вхождений
+    // с номерами из [first_ordinal, last_ordinal) в порядке возрастания
+    template <typename Function>
+    void ForEachInRange(int first_ordinal, int last_ordinal, Function function) const;
+    template <typename Function>
+    void ForEach(Function function) const;
+
+    PostingEncoding GetEncoding() const;
+    void SetEncoding(PostingEncoding encoding);
+
+    // Верхняя граница частот слова в списке; после удалений может быть завышена
+    double GetMaxTermFreq() const;
+
+    size_t size() const;
+    bool empty() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    struct CompressedBlock {
+        int first_ordinal;
+        int last_ordinal;
+        int count;
+        int gap_width;
+        std::vector<uint8_t> gaps;
+        std::vector<float> term_freqs;
+    };
+
+    PostingEncoding encoding_;
+    size_t size_ = 0;
+    double max_term_freq_ = 0.0;
+    std::vector<Posting> postings_;
+    std::vector<CompressedBlock> blocks_;
+
+    static CompressedBlock EncodeBlock(const Posting* first, int count);
+    static void DecodeBlock(const CompressedBlock& block, std::vector<Posting>& postings);
+    std::vector<Posting> DecodeAll() const;
+    void EncodeAll(const std::vector<Posting>& postings);
+    std::vector<CompressedBlock>::const_iterator FindBlock(int document_ordinal) const;
+    void ReplaceBlock(size_t block_index, const std::vector<Posting>& postings);
+};
+
+// Однонаправленный проход по списку вхождений с пропуском до заданного номера.
+// Для сжатого списка в курсоре хранится текущий декодированный блок
+class PostingList::Cursor {
+public:
+    explicit Cursor(const PostingList& postings);
+
+    int GetDocumentOrdinal() const {
+        return document_ordinal_;
+    }
+
+    double GetTermFreq() const {
+        return postings_->encoding_ == PostingEncoding::PLAIN ? current_->term_freq : static_cast<double>(term_freqs_[position_]);
+    }
+
+    void Next() {
+        if (postings_->encoding_ == PostingEncoding::PLAIN) {
+            ++current_;
+            document_ordinal_ = current_ != end_ ? current_->document_ordinal : END_ORDINAL;
+        }
+        else if (++position_ < block_count_) {
+            document_ordinal_ = ordinals_[position_];
+        }
+        else {
+            LoadBlock(block_index_ + 1);
+        }
+    }
+
+    // Переходит к первому вхождению с номером не меньше document_ordinal
+    void SkipTo(int document_ordinal);
+
+private:
+    const PostingList* postings_;
+    int document_ordinal_ = END_ORDINAL;
+    const Posting* current_ = nullptr;
+    const Posting* end_ = nullptr;
+    size_t block_index_ = 0;
+    int position_ = 0;
+    int block_count_ = 0;
+    const float* term_freqs_ = nullptr;
+    int ordinals_[BLOCK_SIZE];
+
+    void LoadBlock(size_t block_index);
+};
+
+template <typename Function>
+void PostingList::ForEachInRange(int first_ordinal, int last_ordinal, Function function) const {
+    if (encoding_ == PostingEncoding::PLAIN) {
+        auto it = std::lower_bound(postings_.begin(), postings_.end(), first_ordinal,
+            [](const Posting& posting, int document_ordinal) {
+                return posting.document_ordinal < document_ordinal;
+            });
+        for (; it != postings_.end() && it->document_ordinal < last_ordinal; ++it) {
+            function(it->document_ordinal, it->term_freq);
+        }
+        return;
+    }
+
+    int ordinals[BLOCK_SIZE];
+    for (auto block = FindBlock(first_ordinal); block != blocks_.end() && block->first_ordinal < last_ordinal; ++block) {
+        DecodePostingGaps(block->gaps.data(), block->gap_width, block->count, block->first_ordinal, ordinals);
+        int i = 0;
+        while (i < block->count && ordinals[i] < first_ordinal) {
+            ++i;
+        }
+        for (; i < block->count && ordinals[i] < last_ordinal; ++i) {
+            function(ordinals[i], static_cast<double>(block->term_freqs[i]));
+        }
+    }
+}
+
+template <typename Function>
+void PostingList::ForEach(Function function) const {
+    ForEachInRange(0, INT32_MAX, function);
+}
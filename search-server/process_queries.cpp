@@ -1,6 +1,13 @@
 #include "process_queries.h"
 #include <execution>
 
+namespace {
+// Запросы обрабатываются группами, порядковые номера — блоками: плотные массивы
+// релевантностей группы занимают QUERY_GROUP_SIZE * ORDINAL_BLOCK_SIZE * 8 байт на поток
+const int QUERY_GROUP_SIZE = 256;
+const int ORDINAL_BLOCK_SIZE = 1024;
+}
+
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries) {
 	std::vector<std::vector<Document>> result(queries.size());
 	std::transform(std::execution::par, queries.begin(), queries.end(), result.begin(), [&search_server](const std::string_view query) {
@@ -9,18 +16,365 @@ std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_ser
 	return result;
 }
 
-std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
-	std::vector<std::vector<Document>> temp = ProcessQueries(search_server, queries);
-	size_t count_size_v = 0;
-	int curr_vector = 0;
-	while (curr_vector != queries.size()) {
-		count_size_v += temp[curr_vector].size();
-		++curr_vector;
-	}
-	std::vector<Document> result;
-	result.reserve(count_size_v);
-	for (auto it = temp.begin(), end = temp.end(); it != end; ++it) {
-		result.insert(result.end(), it->begin(), it->end());
+class QueryBatchEngine {
+public:
+	static QueryBatchResult Run(const SearchServer& search_server, const std::vector<std::string>& queries, DocumentStatus status);
+
+	static bool IsQueryCacheEnabled(const SearchServer& search_server) {
+		return search_server.query_cache_.GetCapacity() > 0;
+	}
+
+private:
+	struct GroupTerm {
+		const PostingList* postings;
+		double inverse_document_freq;
+		// Номера запросов внутри группы
+		std::vector<int> queries;
+		// Для плюс-слова: верхняя граница суммарного вклада этого и следующих слов запроса
+		std::vector<double> score_bounds;
+	};
+
+	// Слова группы запросов в общем порядке плана: по убыванию IDF, при равенстве по алфавиту.
+	// Для каждого запроса это тот же порядок, что и в PlanQueryTerms, поэтому
+	// релевантность суммируется так же, как в FindTopDocuments
+	struct QueryGroup {
+		int first_query = 0;
+		int query_count = 0;
+		std::vector<GroupTerm> plus_terms;
+		std::vector<GroupTerm> minus_terms;
+		// Запросы со словом, которое есть во всех документах
+		std::vector<int> universal_queries;
+	};
+
+	struct TopRelevances {
+		std::priority_queue<double, std::vector<double>, std::greater<double>> relevances;
+		double threshold = -std::numeric_limits<double>::infinity();
+	};
+
+	static std::vector<QueryGroup> PlanGroups(const SearchServer& search_server, const std::vector<SearchServer::Query>& parsed_queries);
+
+	template <typename DocumentAcceptor>
+	static void ScoreGroupRange(const SearchServer& search_server, const QueryGroup& group, int first_ordinal, int last_ordinal,
+		const DocumentAcceptor& accepts_document, std::vector<std::vector<Document>>& candidates);
+};
+
+std::vector<QueryBatchEngine::QueryGroup> QueryBatchEngine::PlanGroups(const SearchServer& search_server, const std::vector<SearchServer::Query>& parsed_queries) {
+	struct TermUsage {
+		int term_id;
+		std::string_view word;
+		double inverse_document_freq;
+		std::vector<int> plus_queries;
+		std::vector<int> minus_queries;
+	};
+
+	// Каждое слово пакета ищется в словаре один раз
+	std::unordered_map<std::string_view, size_t> word_to_usage;
+	std::vector<TermUsage> usages;
+	std::vector<char> is_universal(parsed_queries.size(), false);
+	const auto find_usage = [&search_server, &word_to_usage, &usages](std::string_view word) -> TermUsage* {
+		const auto [it, inserted] = word_to_usage.emplace(word, usages.size());
+		if (inserted) {
+			const int term_id = search_server.terms_.Find(word);
+			const double inverse_document_freq = term_id == SearchServer::NO_TERM ? 0.0 : search_server.ComputeTermInverseDocumentFreq(term_id);
+			usages.push_back({ term_id, word, inverse_document_freq, {}, {} });
+		}
+		TermUsage& usage = usages[it->second];
+		return usage.term_id == SearchServer::NO_TERM ? nullptr : &usage;
+	};
+	for (size_t query = 0; query < parsed_queries.size(); ++query) {
+		for (const std::string_view word : parsed_queries[query].plus_words) {
+			if (TermUsage* usage = find_usage(word)) {
+				if (usage->inverse_document_freq == 0.0) {
+					is_universal[query] = true;
+				}
+				else {
+					usage->plus_queries.push_back(static_cast<int>(query));
+				}
+			}
+		}
+		for (const std::string_view word : parsed_queries[query].minus_words) {
+			if (TermUsage* usage = find_usage(word)) {
+				usage->minus_queries.push_back(static_cast<int>(query));
+			}
+		}
+	}
+	std::sort(usages.begin(), usages.end(), [](const TermUsage& lhs, const TermUsage& rhs) {
+		return lhs.inverse_document_freq != rhs.inverse_document_freq ? lhs.inverse_document_freq > rhs.inverse_document_freq : lhs.word < rhs.word;
+	});
+
+	const int query_count = static_cast<int>(parsed_queries.size());
+	std::vector<QueryGroup> groups((query_count + QUERY_GROUP_SIZE - 1) / QUERY_GROUP_SIZE);
+	// Номера запросов в usage возрастают, поэтому группе соответствует их отрезок
+	const auto select_group_queries = [](const std::vector<int>& queries, const QueryGroup& group) {
+		const auto first = std::lower_bound(queries.begin(), queries.end(), group.first_query);
+		const auto last = std::lower_bound(first, queries.end(), group.first_query + group.query_count);
+		std::vector<int> group_queries(first, last);
+		for (int& query : group_queries) {
+			query -= group.first_query;
+		}
+		return group_queries;
+	};
+	for (size_t g = 0; g < groups.size(); ++g) {
+		QueryGroup& group = groups[g];
+		group.first_query = static_cast<int>(g) * QUERY_GROUP_SIZE;
+		group.query_count = std::min(QUERY_GROUP_SIZE, query_count - group.first_query);
+		for (const TermUsage& usage : usages) {
+			if (usage.term_id == SearchServer::NO_TERM) {
+				continue;
+			}
+			const PostingList* postings = &search_server.term_postings_[usage.term_id];
+			std::vector<int> plus_queries = select_group_queries(usage.plus_queries, group);
+			if (!plus_queries.empty()) {
+				group.plus_terms.push_back({ postings, usage.inverse_document_freq, std::move(plus_queries), {} });
+			}
+			std::vector<int> minus_queries = select_group_queries(usage.minus_queries, group);
+			if (!minus_queries.empty()) {
+				group.minus_terms.push_back({ postings, usage.inverse_document_freq, std::move(minus_queries), {} });
+			}
+		}
+		std::vector<double> query_bounds(group.query_count);
+		for (auto term = group.plus_terms.rbegin(); term != group.plus_terms.rend(); ++term) {
+			const double max_score = term->postings->GetMaxTermFreq() * term->inverse_document_freq;
+			for (const int query : term->queries) {
+				query_bounds[query] += max_score;
+				term->score_bounds.push_back(query_bounds[query]);
+			}
+		}
+		for (int query = 0; query < group.query_count; ++query) {
+			if (is_universal[group.first_query + query]) {
+				group.universal_queries.push_back(query);
+			}
+		}
+	}
+	return groups;
+}
+
+template <typename DocumentAcceptor>
+void QueryBatchEngine::ScoreGroupRange(const SearchServer& search_server, const QueryGroup& group, int first_ordinal, int last_ordinal,
+	const DocumentAcceptor& accepts_document, std::vector<std::vector<Document>>& candidates) {
+	enum : uint8_t { UNSEEN, MATCHED, EXCLUDED };
+
+	const size_t result_count = static_cast<size_t>(search_server.max_result_document_count_);
+	if (result_count == 0 || first_ordinal >= last_ordinal) {
+		return;
+	}
+	std::vector<PostingList::Cursor> plus_cursors;
+	plus_cursors.reserve(group.plus_terms.size());
+	for (const GroupTerm& term : group.plus_terms) {
+		plus_cursors.emplace_back(*term.postings);
+		plus_cursors.back().SkipTo(first_ordinal);
+	}
+	std::vector<PostingList::Cursor> minus_cursors;
+	minus_cursors.reserve(group.minus_terms.size());
+	for (const GroupTerm& term : group.minus_terms) {
+		minus_cursors.emplace_back(*term.postings);
+		minus_cursors.back().SkipTo(first_ordinal);
 	}
+
+	// Ячейка query * ORDINAL_BLOCK_SIZE + (document_ordinal - block_first) хранит состояние
+	// и релевантность документа для запроса; после блока сбрасываются только затронутые ячейки
+	const size_t cell_count = static_cast<size_t>(group.query_count) * ORDINAL_BLOCK_SIZE;
+	std::vector<double> relevances(cell_count);
+	std::vector<uint8_t> states(cell_count, UNSEEN);
+	std::vector<uint32_t> touched_cells;
+	std::vector<TopRelevances> tops(group.query_count);
+	// Есть ли у документа блока ячейка MATCHED хотя бы в одном запросе
+	std::vector<char> has_matches(ORDINAL_BLOCK_SIZE);
+	std::vector<int> open_queries;
+	std::vector<int> closed_queries;
+
+	for (int block_first = first_ordinal; block_first < last_ordinal; block_first += ORDINAL_BLOCK_SIZE) {
+		const int block_last = std::min(last_ordinal, block_first + ORDINAL_BLOCK_SIZE);
+		for (size_t k = 0; k < minus_cursors.size(); ++k) {
+			PostingList::Cursor& cursor = minus_cursors[k];
+			for (; cursor.GetDocumentOrdinal() < block_last; cursor.Next()) {
+				const uint32_t index = static_cast<uint32_t>(cursor.GetDocumentOrdinal() - block_first);
+				for (const int query : group.minus_terms[k].queries) {
+					const uint32_t cell = static_cast<uint32_t>(query) * ORDINAL_BLOCK_SIZE + index;
+					if (states[cell] == UNSEEN) {
+						touched_cells.push_back(cell);
+					}
+					states[cell] = EXCLUDED;
+				}
+			}
+		}
+		// Документ без плюс-слов запроса имеет нулевую релевантность и нужен, только пока порог не выше нуля
+		open_queries.clear();
+		for (const int query : group.universal_queries) {
+			if (tops[query].threshold <= 0.0) {
+				open_queries.push_back(query);
+			}
+		}
+		if (!open_queries.empty()) {
+			for (int document_ordinal = block_first; document_ordinal < block_last; ++document_ordinal) {
+				if (search_server.documents_[document_ordinal].id == SearchServer::NO_DOCUMENT || !accepts_document(document_ordinal)) {
+					continue;
+				}
+				for (const int query : open_queries) {
+					const uint32_t cell = static_cast<uint32_t>(query) * ORDINAL_BLOCK_SIZE + (document_ordinal - block_first);
+					if (states[cell] == UNSEEN) {
+						states[cell] = MATCHED;
+						relevances[cell] = 0.0;
+						touched_cells.push_back(cell);
+						has_matches[document_ordinal - block_first] = true;
+					}
+				}
+			}
+		}
+		for (size_t k = 0; k < plus_cursors.size(); ++k) {
+			// Если оставшиеся слова запроса не могут поднять новый документ до порога,
+			// запрос только дополняет релевантность уже найденных документов блока
+			const GroupTerm& term = group.plus_terms[k];
+			open_queries.clear();
+			closed_queries.clear();
+			for (size_t i = 0; i < term.queries.size(); ++i) {
+				(term.score_bounds[i] < tops[term.queries[i]].threshold ? closed_queries : open_queries).push_back(term.queries[i]);
+			}
+			PostingList::Cursor& cursor = plus_cursors[k];
+			for (; cursor.GetDocumentOrdinal() < block_last; cursor.Next()) {
+				const int document_ordinal = cursor.GetDocumentOrdinal();
+				const uint32_t index = static_cast<uint32_t>(document_ordinal - block_first);
+				if ((open_queries.empty() && !has_matches[index]) || !accepts_document(document_ordinal)) {
+					continue;
+				}
+				const double contribution = cursor.GetTermFreq() * term.inverse_document_freq;
+				for (const int query : open_queries) {
+					const uint32_t cell = static_cast<uint32_t>(query) * ORDINAL_BLOCK_SIZE + index;
+					if (states[cell] == EXCLUDED) {
+						continue;
+					}
+					if (states[cell] == UNSEEN) {
+						states[cell] = MATCHED;
+						relevances[cell] = 0.0;
+						touched_cells.push_back(cell);
+						has_matches[index] = true;
+					}
+					relevances[cell] += contribution;
+				}
+				if (has_matches[index]) {
+					for (const int query : closed_queries) {
+						const uint32_t cell = static_cast<uint32_t>(query) * ORDINAL_BLOCK_SIZE + index;
+						if (states[cell] == MATCHED) {
+							relevances[cell] += contribution;
+						}
+					}
+				}
+			}
+		}
+
+		// Кандидаты отбираются с тем же порогом, что в MaxScore
+		for (const uint32_t cell : touched_cells) {
+			if (states[cell] == MATCHED) {
+				const int query = static_cast<int>(cell / ORDINAL_BLOCK_SIZE);
+				const double relevance = relevances[cell];
+				TopRelevances& top = tops[query];
+				if (relevance >= top.threshold) {
+					const auto& document_data = search_server.documents_[block_first + cell % ORDINAL_BLOCK_SIZE];
+					candidates[query].push_back({ document_data.id, relevance, document_data.rating });
+					top.relevances.push(relevance);
+					if (top.relevances.size() > result_count) {
+						top.relevances.pop();
+					}
+					if (top.relevances.size() == result_count && top.relevances.top() - EPSILON > top.threshold) {
+						top.threshold = top.relevances.top() - EPSILON;
+					}
+				}
+			}
+			states[cell] = UNSEEN;
+		}
+		touched_cells.clear();
+		std::fill(has_matches.begin(), has_matches.end(), false);
+	}
+}
+
+QueryBatchResult QueryBatchEngine::Run(const SearchServer& search_server, const std::vector<std::string>& queries, DocumentStatus status) {
+	// Исключение внутри параллельного алгоритма вызывает std::terminate,
+	// поэтому ошибки разбора запоминаются и обрабатываются после
+	std::vector<SearchServer::Query> parsed_queries(queries.size());
+	std::vector<char> is_valid(queries.size(), true);
+	std::vector<size_t> indexes(queries.size());
+	std::iota(indexes.begin(), indexes.end(), 0);
+	std::for_each(std::execution::par, indexes.begin(), indexes.end(),
+		[&search_server, &queries, &parsed_queries, &is_valid](size_t i) {
+			try {
+				parsed_queries[i] = search_server.ParseQuery(queries[i]);
+			}
+			catch (const std::invalid_argument&) {
+				is_valid[i] = false;
+			}
+		});
+	if (std::find(is_valid.begin(), is_valid.end(), false) != is_valid.end()) {
+		throw std::invalid_argument("ProcessQueriesBatch, invalid query");
+	}
+
+	const std::vector<QueryGroup> groups = PlanGroups(search_server, parsed_queries);
+	const DocumentFilter document_filter(status);
+	std::vector<uint64_t> status_words;
+	const auto accepts_document = search_server.MakeDocumentAcceptor(document_filter, status_words);
+
+	// Задача — пара (группа запросов, часть порядковых номеров)
+	const int ordinal_count = static_cast<int>(search_server.documents_.size());
+	const int chunk_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	const int chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+	std::vector<std::vector<std::vector<Document>>> task_candidates(groups.size() * chunk_count);
+	std::vector<size_t> tasks(task_candidates.size());
+	std::iota(tasks.begin(), tasks.end(), 0);
+	std::for_each(std::execution::par, tasks.begin(), tasks.end(),
+		[&](size_t task) {
+			const QueryGroup& group = groups[task / chunk_count];
+			const int chunk = static_cast<int>(task % chunk_count);
+			const int first_ordinal = std::min(ordinal_count, chunk * chunk_size);
+			const int last_ordinal = std::min(ordinal_count, first_ordinal + chunk_size);
+			task_candidates[task].resize(group.query_count);
+			ScoreGroupRange(search_server, group, first_ordinal, last_ordinal, accepts_document, task_candidates[task]);
+		});
+
+	// Кандидаты запроса собираются в части с нулевым номером
+	std::for_each(std::execution::par, indexes.begin(), indexes.end(),
+		[&search_server, &task_candidates, chunk_count](size_t query) {
+			const size_t first_task = query / QUERY_GROUP_SIZE * chunk_count;
+			const size_t group_query = query % QUERY_GROUP_SIZE;
+			std::vector<Document>& documents = task_candidates[first_task][group_query];
+			for (int chunk = 1; chunk < chunk_count; ++chunk) {
+				const std::vector<Document>& chunk_documents = task_candidates[first_task + chunk][group_query];
+				documents.insert(documents.end(), chunk_documents.begin(), chunk_documents.end());
+			}
+			search_server.SelectTopDocuments(std::execution::seq, documents);
+		});
+
+	QueryBatchResult result;
+	result.offsets.resize(queries.size() + 1);
+	for (size_t query = 0; query < queries.size(); ++query) {
+		const size_t first_task = query / QUERY_GROUP_SIZE * chunk_count;
+		result.offsets[query + 1] = result.offsets[query] + task_candidates[first_task][query % QUERY_GROUP_SIZE].size();
+	}
+	result.documents.resize(result.offsets.back());
+	std::for_each(std::execution::par, indexes.begin(), indexes.end(),
+		[&result, &task_candidates, chunk_count](size_t query) {
+			const std::vector<Document>& documents = task_candidates[query / QUERY_GROUP_SIZE * chunk_count][query % QUERY_GROUP_SIZE];
+			std::copy(documents.begin(), documents.end(), result.documents.begin() + result.offsets[query]);
+		});
 	return result;
-} 
\ No newline at end of file
+}
+
+QueryBatchResult ProcessQueriesBatch(const SearchServer& search_server, const std::vector<std::string>& queries, DocumentStatus status) {
+	return QueryBatchEngine::Run(search_server, queries, status);
+}
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
+	if (!QueryBatchEngine::IsQueryCacheEnabled(search_server)) {
+		return ProcessQueriesBatch(search_server, queries).documents;
+	}
+	// С включённым кешем запросы выполняются через FindTopDocuments, как в ProcessQueries
+	const std::vector<std::vector<Document>> results = ProcessQueries(search_server, queries);
+	size_t document_count = 0;
+	for (const auto& documents : results) {
+		document_count += documents.size();
+	}
+	std::vector<Document> joined;
+	joined.reserve(document_count);
+	for (const auto& documents : results) {
+		joined.insert(joined.end(), documents.begin(), documents.end());
+	}
+	return joined;
+}
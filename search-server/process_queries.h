@@ -1,5 +1,19 @@
 #pragma once
 #include "search_server.h"
 
+// Результаты пакета запросов в одном массиве: документы запроса i
+// лежат в documents[offsets[i], offsets[i + 1])
+struct QueryBatchResult {
+	std::vector<Document> documents;
+	std::vector<size_t> offsets;
+};
+
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
+// Результаты ProcessQueries одним массивом. Если у сервера включён кеш запросов, запросы
+// выполняются через него, иначе — пакетно, как в ProcessQueriesBatch
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// Пакетное выполнение: каждое слово пакета ищется в словаре и его список вхождений
+// читается один раз для всех запросов, где оно встречается. Результат запроса
+// совпадает с FindTopDocuments(query, status), кеш запросов не используется
+QueryBatchResult ProcessQueriesBatch(const SearchServer& search_server, const std::vector<std::string>& queries, DocumentStatus status = DocumentStatus::ACTUAL);
@@ -0,0 +1,86 @@
+#include "query_cache.h"
+
+QueryResultCache::QueryResultCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+QueryResultCache::QueryResultCache(const QueryResultCache& other)
+    : capacity_(other.GetCapacity()) {
+}
+
+QueryResultCache& QueryResultCache::operator=(const QueryResultCache& other) {
+    if (this != &other) {
+        const size_t capacity = other.GetCapacity();
+        std::lock_guard guard(mutex_);
+        capacity_ = capacity;
+        key_to_entry_.clear();
+        entries_.clear();
+    }
+    return *this;
+}
+
+bool QueryResultCache::Find(const std::string& key, uint64_t generation, std::vector<Document>& documents) {
+    std::lock_guard guard(mutex_);
+    const auto it = key_to_entry_.find(key);
+    if (it == key_to_entry_.end()) {
+        ++misses_;
+        return false;
+    }
+    if (it->second->generation != generation) {
+        entries_.erase(it->second);
+        key_to_entry_.erase(it);
+        ++misses_;
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    documents = it->second->documents;
+    ++hits_;
+    return true;
+}
+
+void QueryResultCache::Insert(std::string key, uint64_t generation, const std::vector<Document>& documents) {
+    std::lock_guard guard(mutex_);
+    if (capacity_ == 0) {
+        return;
+    }
+    const auto it = key_to_entry_.find(key);
+    if (it != key_to_entry_.end()) {
+        // Запись могли добавить параллельно выполнявшиеся такие же запросы
+        it->second->generation = generation;
+        it->second->documents = documents;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.push_front({ std::move(key), generation, documents });
+    key_to_entry_.emplace(entries_.front().key, entries_.begin());
+    EvictExcess();
+}
+
+void QueryResultCache::SetCapacity(size_t capacity) {
+    std::lock_guard guard(mutex_);
+    capacity_ = capacity;
+    EvictExcess();
+}
+
+size_t QueryResultCache::GetCapacity() const {
+    std::lock_guard guard(mutex_);
+    return capacity_;
+}
+
+void QueryResultCache::Clear() {
+    std::lock_guard guard(mutex_);
+    key_to_entry_.clear();
+    entries_.clear();
+}
+
+QueryCacheStats QueryResultCache::GetStats() const {
+    std::lock_guard guard(mutex_);
+    return { hits_, misses_, entries_.size() };
+}
+
+void QueryResultCache::EvictExcess() {
+    while (entries_.size() > capacity_) {
+        key_to_entry_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
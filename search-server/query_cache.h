@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t size = 0;
+};
+
+// Ограниченный LRU-кеш результатов поиска. Каждая запись помечена поколением индекса,
+// на котором она вычислена; запись другого поколения считается промахом и удаляется.
+// Все методы потокобезопасны. Копия кеша начинается пустой с той же ёмкостью.
+class QueryResultCache {
+public:
+    explicit QueryResultCache(size_t capacity = 0);
+    QueryResultCache(const QueryResultCache& other);
+    QueryResultCache& operator=(const QueryResultCache& other);
+
+    // Возвращает true и заполняет documents, если для key есть запись поколения generation
+    bool Find(const std::string& key, uint64_t generation, std::vector<Document>& documents);
+    void Insert(std::string key, uint64_t generation, const std::vector<Document>& documents);
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+    void Clear();
+    QueryCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    // От недавно использованных записей к давно использованным
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> key_to_entry_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+
+    void EvictExcess();
+};
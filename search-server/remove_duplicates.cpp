@@ -1,21 +1,269 @@
 #include "remove_duplicates.h"
 
-void RemoveDuplicates(SearchServer& search_server) {
-	std::set<int> duplicates;
-	std::set<std::vector<std::string>> matched_words;
-	for (int document_id : search_server) {
-		std::vector<std::string> words_in_doc;
-		for (const auto& [words, _] : search_server.GetWordFrequencies(document_id)) {
-			words_in_doc.push_back(words);
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+namespace {
+uint64_t MixHash(uint64_t value) {
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+// Отпечаток набора слов: суммы двух независимых хешей id слов не зависят от их порядка
+struct SetFingerprint {
+	uint64_t first = 0;
+	uint64_t second = 0;
+	int size = 0;
+};
+
+bool operator==(const SetFingerprint& lhs, const SetFingerprint& rhs) {
+	return lhs.first == rhs.first && lhs.second == rhs.second && lhs.size == rhs.size;
+}
+
+bool operator<(const SetFingerprint& lhs, const SetFingerprint& rhs) {
+	return std::tie(lhs.first, lhs.second, lhs.size) < std::tie(rhs.first, rhs.second, rhs.size);
+}
+
+bool HaveSameWords(const std::map<std::string_view, double>& lhs, const std::map<std::string_view, double>& rhs) {
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+		[](const auto& lhs_word, const auto& rhs_word) {
+			return lhs_word.first == rhs_word.first;
+		});
+}
+
+double ComputeJaccardSimilarity(const std::map<std::string_view, double>& lhs, const std::map<std::string_view, double>& rhs) {
+	if (lhs.empty() && rhs.empty()) {
+		return 1.0;
+	}
+	size_t common_count = 0;
+	auto lhs_it = lhs.begin();
+	auto rhs_it = rhs.begin();
+	while (lhs_it != lhs.end() && rhs_it != rhs.end()) {
+		if (lhs_it->first < rhs_it->first) {
+			++lhs_it;
+		}
+		else if (rhs_it->first < lhs_it->first) {
+			++rhs_it;
+		}
+		else {
+			++common_count;
+			++lhs_it;
+			++rhs_it;
+		}
+	}
+	return static_cast<double>(common_count) / static_cast<double>(lhs.size() + rhs.size() - common_count);
+}
+}
+
+class DuplicateFinder {
+public:
+	template <typename Policy>
+	static std::vector<int> Find(const Policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options);
+
+private:
+	struct DocumentEntry {
+		SetFingerprint fingerprint;
+		int id;
+		int ordinal;
+	};
+
+	struct BandEntry {
+		uint64_t key;
+		int id;
+		int ordinal;
+	};
+
+	struct NearCandidate {
+		int id;
+		size_t position;
+		size_t group_begin;
+	};
+};
+
+template <typename Policy>
+std::vector<int> DuplicateFinder::Find(const Policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	if (!(options.similarity_threshold > 0.0 && options.similarity_threshold <= 1.0)) {
+		throw std::invalid_argument("FindDuplicates, similarity threshold must be in (0, 1]");
+	}
+	const bool find_near_duplicates = options.similarity_threshold < 1.0;
+	if (find_near_duplicates && (options.signature_size <= 0 || options.band_count <= 0 || options.signature_size % options.band_count != 0)) {
+		throw std::invalid_argument("FindDuplicates, signature size must be a positive multiple of band count");
+	}
+	const size_t signature_size = find_near_duplicates ? static_cast<size_t>(options.signature_size) : 0;
+	const auto& word_freqs = search_server.document_word_freqs_;
+
+	// MinHash-значения зависят только от слова, поэтому вычисляются один раз на слово,
+	// а не для каждого его вхождения
+	const size_t term_count = search_server.term_postings_.size();
+	std::vector<uint32_t> term_minhashes(term_count * signature_size);
+	if (signature_size > 0) {
+		std::vector<size_t> term_ids(term_count);
+		std::iota(term_ids.begin(), term_ids.end(), 0);
+		std::for_each(policy, term_ids.begin(), term_ids.end(),
+			[&search_server, &term_minhashes, signature_size](size_t term_id) {
+				if (search_server.term_postings_[term_id].empty()) {
+					return;
+				}
+				const uint64_t first_hash = MixHash(term_id);
+				const uint64_t second_hash = MixHash(first_hash);
+				uint32_t* minhashes = term_minhashes.data() + term_id * signature_size;
+				for (size_t i = 0; i < signature_size; ++i) {
+					minhashes[i] = static_cast<uint32_t>(MixHash(first_hash + i * second_hash) >> 32);
+				}
+			});
+	}
+
+	// Отпечатки и MinHash-подписи строятся за один проход по спискам вхождений;
+	// каждый поток обрабатывает свой диапазон порядковых номеров
+	const int ordinal_count = static_cast<int>(search_server.documents_.size());
+	std::vector<SetFingerprint> fingerprints(ordinal_count);
+	std::vector<uint32_t> signatures(static_cast<size_t>(ordinal_count) * signature_size, UINT32_MAX);
+	const int chunk_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	const int chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+	std::vector<int> chunks(chunk_count);
+	std::iota(chunks.begin(), chunks.end(), 0);
+	std::for_each(policy, chunks.begin(), chunks.end(),
+		[&search_server, &fingerprints, &signatures, &term_minhashes, signature_size, term_count, ordinal_count, chunk_size](int chunk) {
+			const int first_ordinal = std::min(ordinal_count, chunk * chunk_size);
+			const int last_ordinal = std::min(ordinal_count, first_ordinal + chunk_size);
+			for (size_t term_id = 0; term_id < term_count; ++term_id) {
+				const PostingList& postings = search_server.term_postings_[term_id];
+				if (postings.empty()) {
+					continue;
+				}
+				const uint64_t first_hash = MixHash(term_id);
+				const uint64_t second_hash = MixHash(first_hash);
+				const uint32_t* minhashes = term_minhashes.data() + term_id * signature_size;
+				postings.ForEachInRange(first_ordinal, last_ordinal, [&, first_hash, second_hash, minhashes](int document_ordinal, double) {
+					SetFingerprint& fingerprint = fingerprints[document_ordinal];
+					fingerprint.first += first_hash;
+					fingerprint.second += second_hash;
+					++fingerprint.size;
+					uint32_t* signature = signatures.data() + static_cast<size_t>(document_ordinal) * signature_size;
+					for (size_t i = 0; i < signature_size; ++i) {
+						signature[i] = std::min(signature[i], minhashes[i]);
+					}
+				});
+			}
+		});
+
+	std::vector<DocumentEntry> documents;
+	documents.reserve(search_server.GetDocumentCount());
+	for (const int document_id : search_server) {
+		const int document_ordinal = search_server.GetDocumentOrdinal(document_id);
+		documents.push_back({ fingerprints[document_ordinal], document_id, document_ordinal });
+	}
+	std::sort(policy, documents.begin(), documents.end(), [](const DocumentEntry& lhs, const DocumentEntry& rhs) {
+		return lhs.fingerprint == rhs.fingerprint ? lhs.id < rhs.id : lhs.fingerprint < rhs.fingerprint;
+	});
+
+	// Документы с одинаковым отпечатком сравниваются по словам, чтобы коллизия хешей
+	// не приняла за дубликат другой документ
+	std::vector<char> is_duplicate(ordinal_count, false);
+	std::vector<int> duplicates;
+	for (size_t group_begin = 0; group_begin < documents.size();) {
+		size_t group_end = group_begin + 1;
+		while (group_end < documents.size() && documents[group_end].fingerprint == documents[group_begin].fingerprint) {
+			++group_end;
+		}
+		std::vector<int> originals{ documents[group_begin].ordinal };
+		for (size_t i = group_begin + 1; i < group_end; ++i) {
+			const auto& words = word_freqs[documents[i].ordinal];
+			const bool is_copy = std::any_of(originals.begin(), originals.end(), [&word_freqs, &words](int original) {
+				return HaveSameWords(word_freqs[original], words);
+			});
+			if (is_copy) {
+				is_duplicate[documents[i].ordinal] = true;
+				duplicates.push_back(documents[i].id);
+			}
+			else {
+				originals.push_back(documents[i].ordinal);
+			}
+		}
+		group_begin = group_end;
+	}
+
+	if (find_near_duplicates) {
+		// Документы, совпавшие хотя бы в одной полосе подписи, становятся кандидатами.
+		// Кандидаты перебираются по возрастанию id, и документ считается дубликатом,
+		// если он похож на оставленный документ с меньшим id
+		const size_t band_count = static_cast<size_t>(options.band_count);
+		const size_t rows = signature_size / band_count;
+		std::vector<BandEntry> bands;
+		bands.reserve(documents.size() * band_count);
+		for (const DocumentEntry& document : documents) {
+			if (is_duplicate[document.ordinal]) {
+				continue;
+			}
+			const uint32_t* signature = signatures.data() + static_cast<size_t>(document.ordinal) * signature_size;
+			for (size_t band = 0; band < band_count; ++band) {
+				uint64_t key = MixHash(band);
+				for (size_t row = 0; row < rows; ++row) {
+					key = MixHash(key ^ signature[band * rows + row]);
+				}
+				bands.push_back({ key, document.id, document.ordinal });
+			}
 		}
-		if (matched_words.count(words_in_doc) > 0) {
-			duplicates.insert(document_id);
-		} else {
-			matched_words.insert(words_in_doc);
+		std::sort(policy, bands.begin(), bands.end(), [](const BandEntry& lhs, const BandEntry& rhs) {
+			return std::tie(lhs.key, lhs.id) < std::tie(rhs.key, rhs.id);
+		});
+
+		std::vector<NearCandidate> candidates;
+		for (size_t group_begin = 0; group_begin < bands.size();) {
+			size_t group_end = group_begin + 1;
+			while (group_end < bands.size() && bands[group_end].key == bands[group_begin].key) {
+				candidates.push_back({ bands[group_end].id, group_end, group_begin });
+				++group_end;
+			}
+			group_begin = group_end;
+		}
+		std::sort(policy, candidates.begin(), candidates.end(), [](const NearCandidate& lhs, const NearCandidate& rhs) {
+			return std::tie(lhs.id, lhs.position) < std::tie(rhs.id, rhs.position);
+		});
+
+		for (const NearCandidate& candidate : candidates) {
+			const int document_ordinal = bands[candidate.position].ordinal;
+			if (is_duplicate[document_ordinal]) {
+				continue;
+			}
+			for (size_t i = candidate.group_begin; i < candidate.position; ++i) {
+				const int original = bands[i].ordinal;
+				if (!is_duplicate[original]
+					&& ComputeJaccardSimilarity(word_freqs[original], word_freqs[document_ordinal]) >= options.similarity_threshold) {
+					is_duplicate[document_ordinal] = true;
+					duplicates.push_back(candidate.id);
+					break;
+				}
+			}
 		}
 	}
-	for (auto id = duplicates.begin(); id != duplicates.end(); ++id) {
-		search_server.RemoveDocument(*id);
-		std::cout << "Found duplicate document id " << (*id) << "\n";
+
+	std::sort(duplicates.begin(), duplicates.end());
+	return duplicates;
+}
+
+std::vector<int> FindDuplicates(const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	return DuplicateFinder::Find(std::execution::seq, search_server, options);
+}
+
+std::vector<int> FindDuplicates(const std::execution::sequenced_policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	return DuplicateFinder::Find(policy, search_server, options);
+}
+
+std::vector<int> FindDuplicates(const std::execution::parallel_policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	return DuplicateFinder::Find(policy, search_server, options);
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server, const DuplicateSearchOptions& options) {
+	const std::vector<int> duplicates = FindDuplicates(std::execution::par, search_server, options);
+	for (const int document_id : duplicates) {
+		search_server.RemoveDocument(document_id);
 	}
-}
\ No newline at end of file
+	return duplicates;
+}
@@ -1,4 +1,25 @@
 #pragma once
+#include <execution>
+#include <vector>
+
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
+// Параметры поиска дубликатов. При similarity_threshold = 1 ищутся документы с точно
+// совпадающим набором слов. При меньшем пороге дополнительно ищутся почти-дубликаты:
+// кандидаты отбираются по MinHash-подписям из signature_size значений, разбитых на
+// band_count полос (LSH), и проверяются точным коэффициентом Жаккара.
+// Подпись занимает signature_size * 4 байт на документ и столько же на слово словаря.
+struct DuplicateSearchOptions {
+	double similarity_threshold = 1.0;
+	int signature_size = 32;
+	int band_count = 8;
+};
+
+// Возвращает отсортированные id дубликатов. Из каждой группы дубликатов
+// остаётся документ с наименьшим id.
+std::vector<int> FindDuplicates(const SearchServer& search_server, const DuplicateSearchOptions& options = {});
+std::vector<int> FindDuplicates(const std::execution::sequenced_policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options = {});
+std::vector<int> FindDuplicates(const std::execution::parallel_policy& policy, const SearchServer& search_server, const DuplicateSearchOptions& options = {});
+
+// Удаляет дубликаты и возвращает их id
+std::vector<int> RemoveDuplicates(SearchServer& search_server, const DuplicateSearchOptions& options = {});
@@ -1,31 +1,137 @@
 #include "request_queue.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+RequestQueue::RequestQueue(const SearchServer& search_server, std::chrono::seconds window)
+    : search_server_(search_server)
+    , window_seconds_(window.count())
+    , bucket_count_(static_cast<size_t>(std::max<int64_t>(window_seconds_, 0)) + 1)
+    , buckets_(std::make_unique<SecondBucket[]>(bucket_count_)) {
+    if (window_seconds_ <= 0) {
+        throw std::invalid_argument("RequestQueue (constructor): window must be positive");
+    }
+}
+
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    auto result = search_server_.FindTopDocuments(raw_query, status);
-    RequestQueue::AddRequest(result.size());
-    return result;
+    return AddFindRequest(std::execution::par, raw_query, status);
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
-    auto result = search_server_.FindTopDocuments(raw_query);
-    RequestQueue::AddRequest(result.size());
-    return result;
+    return AddFindRequest(std::execution::par, raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return no_result_requests_;
+    return static_cast<int>(GetStats().no_result_count);
 }
 
-void RequestQueue::AddRequest(int results_num) {
-    ++current_time_;
-    while (!requests_.empty() && min_in_day_ <= current_time_ - requests_.front().time) {
-        if (0 == requests_.front().result) {
-            --no_result_requests_;
+RequestQueueStats RequestQueue::GetStats() const {
+    const auto now = Clock::now();
+    const int64_t current_second = GetSecond(now);
+    RequestQueueStats stats;
+    HistogramSnapshot& latency = stats.latency;
+    for (size_t i = 0; i < bucket_count_; ++i) {
+        const SecondBucket& bucket = buckets_[i];
+        const int64_t second = bucket.second.load(std::memory_order_acquire);
+        if (second < 0 || second <= current_second - window_seconds_ || second > current_second) {
+            continue;
+        }
+        HistogramSnapshot bucket_latency;
+        const uint64_t request_count = bucket.request_count.load(std::memory_order_relaxed);
+        const uint64_t no_result_count = bucket.no_result_count.load(std::memory_order_relaxed);
+        bucket_latency.total_ns = bucket.total_latency_ns.load(std::memory_order_relaxed);
+        bucket_latency.max_ns = bucket.max_latency_ns.load(std::memory_order_relaxed);
+        for (int j = 0; j < HistogramSnapshot::BUCKET_COUNT; ++j) {
+            bucket_latency.buckets[j] = bucket.latency_buckets[j].load(std::memory_order_relaxed);
+            bucket_latency.count += bucket_latency.buckets[j];
+        }
+        // Корзину успели отдать новой секунде — прочитанные значения не относятся к окну
+        if (bucket.second.load(std::memory_order_acquire) != second) {
+            continue;
         }
-        requests_.pop_front();
+        stats.request_count += request_count;
+        stats.no_result_count += no_result_count;
+        latency.count += bucket_latency.count;
+        latency.total_ns += bucket_latency.total_ns;
+        latency.max_ns = std::max(latency.max_ns, bucket_latency.max_ns);
+        for (int j = 0; j < HistogramSnapshot::BUCKET_COUNT; ++j) {
+            latency.buckets[j] += bucket_latency.buckets[j];
+        }
+    }
+
+    // Пока окно не заполнено, пропускная способность считается по прошедшему времени
+    const double elapsed_seconds = std::min<double>(static_cast<double>(window_seconds_),
+        std::chrono::duration<double>(now - start_time_).count());
+    if (elapsed_seconds > 0.0) {
+        stats.queries_per_second = stats.request_count / elapsed_seconds;
     }
-    requests_.push_back({ current_time_, results_num });
+    if (stats.request_count > 0) {
+        stats.no_result_rate = static_cast<double>(stats.no_result_count) / stats.request_count;
+    }
+    return stats;
+}
+
+int64_t RequestQueue::GetSecond(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::seconds>(time - start_time_).count();
+}
+
+RequestQueue::SecondBucket* RequestQueue::AcquireBucket(int64_t second) {
+    SecondBucket& bucket = buckets_[static_cast<size_t>(second) % bucket_count_];
+    while (true) {
+        int64_t bucket_second = bucket.second.load();
+        if (bucket_second == second) {
+            // Писатель отмечается до повторной проверки метки, а очистка меняет метку до проверки
+            // числа писателей, поэтому либо писатель увидит очистку, либо очистка дождётся писателя
+            bucket.writer_count.fetch_add(1);
+            if (bucket.second.load() == second) {
+                return &bucket;
+            }
+            bucket.writer_count.fetch_sub(1);
+            continue;
+        }
+        if (bucket_second > second) {
+            // Запрос выполнялся дольше окна, его секунда уже вытеснена
+            return nullptr;
+        }
+        if (bucket_second == RESETTING_SECOND) {
+            // Другой поток очищает корзину; это происходит раз в секунду и занимает микросекунды
+            std::this_thread::yield();
+            continue;
+        }
+        if (bucket.second.compare_exchange_weak(bucket_second, RESETTING_SECOND)) {
+            // Единственное место, где поток блокируется: обнулять счётчики, пока в них пишут, нельзя
+            while (bucket.writer_count.load() != 0) {
+                std::this_thread::yield();
+            }
+            bucket.request_count.store(0, std::memory_order_relaxed);
+            bucket.no_result_count.store(0, std::memory_order_relaxed);
+            bucket.total_latency_ns.store(0, std::memory_order_relaxed);
+            bucket.max_latency_ns.store(0, std::memory_order_relaxed);
+            for (auto& latency_bucket : bucket.latency_buckets) {
+                latency_bucket.store(0, std::memory_order_relaxed);
+            }
+            bucket.second.store(second, std::memory_order_release);
+        }
+    }
+}
+
+void RequestQueue::AddRequest(Clock::time_point start_time, size_t results_num) {
+    const auto end_time = Clock::now();
+    SecondBucket* bucket = AcquireBucket(GetSecond(end_time));
+    if (bucket == nullptr) {
+        return;
+    }
+    const uint64_t latency_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    bucket->request_count.fetch_add(1, std::memory_order_relaxed);
     if (0 == results_num) {
-        ++no_result_requests_;
+        bucket->no_result_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    bucket->total_latency_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    bucket->latency_buckets[HistogramSnapshot::GetBucketIndex(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max_latency_ns = bucket->max_latency_ns.load(std::memory_order_relaxed);
+    while (latency_ns > max_latency_ns
+        && !bucket->max_latency_ns.compare_exchange_weak(max_latency_ns, latency_ns, std::memory_order_relaxed)) {
     }
+    bucket->writer_count.fetch_sub(1, std::memory_order_release);
 }
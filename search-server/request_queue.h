@@ -1,39 +1,102 @@
 #pragma once
-#include <stack>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <execution>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "search_server.h"
 #include "document.h"
+#include "metrics.h"
 
+// Статистика запросов за скользящее окно
+struct RequestQueueStats {
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    double queries_per_second = 0.0;
+    // Доля запросов без результатов, от 0 до 1
+    double no_result_rate = 0.0;
+    // Задержки запросов в наносекундах
+    HistogramSnapshot latency;
+};
+
+// Обёртка над SearchServer, которая ведёт статистику запросов за последние window секунд.
+// Статистика хранится в кольце посекундных корзин с атомарными счётчиками, поэтому
+// AddFindRequest можно вызывать из нескольких потоков одновременно. Без явной политики
+// запрос выполняется параллельной версией FindTopDocuments.
+// Запись не свободна от блокировок: поток, отдающий корзину новой секунде, ждёт, пока
+// писатели прежней секунды закончат свои атомарные операции, а писатели новой секунды
+// ждут конца очистки. Это случается раз в секунду, но вытесненный планировщиком писатель
+// задерживает очистку на время своего простоя. GetStats никого не ждёт.
+// Корзина содержит гистограмму задержек из HistogramSnapshot::BUCKET_COUNT счётчиков,
+// поэтому очередь занимает около 8 КБ на секунду окна (~476 КБ при окне 60 секунд)
 class RequestQueue {
 public:
-    RequestQueue(const SearchServer& search_server)
-        : search_server_(search_server)
-        , no_result_requests_(0)
-        , current_time_(0) {
-    }
+    static constexpr std::chrono::seconds DEFAULT_WINDOW{ 60 };
+
+    RequestQueue(const SearchServer& search_server, std::chrono::seconds window = DEFAULT_WINDOW);
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(const Policy& policy, const std::string& raw_query, DocumentPredicate document_predicate);
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string& raw_query);
+    template <typename Policy>
+    std::vector<Document> AddFindRequest(const Policy& policy, const std::string& raw_query);
+
+    // Число запросов без результатов за окно
     int GetNoResultRequests() const;
+    RequestQueueStats GetStats() const;
+
 private:
-    struct QueryResult {
-        int time;
-        int result;
+    using Clock = std::chrono::steady_clock;
+
+    // Метки корзины, ещё не принадлежащей ни одной секунде и очищаемой в данный момент
+    static constexpr int64_t EMPTY_SECOND = -1;
+    static constexpr int64_t RESETTING_SECOND = -2;
+
+    struct SecondBucket {
+        std::atomic<int64_t> second{ EMPTY_SECOND };
+        // Писатели, которые обновляют корзину; очистка ждёт, пока их не останется
+        std::atomic<int> writer_count{ 0 };
+        std::atomic<uint64_t> request_count{ 0 };
+        std::atomic<uint64_t> no_result_count{ 0 };
+        std::atomic<uint64_t> total_latency_ns{ 0 };
+        std::atomic<uint64_t> max_latency_ns{ 0 };
+        std::array<std::atomic<uint64_t>, HistogramSnapshot::BUCKET_COUNT> latency_buckets{};
     };
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
+
     const SearchServer& search_server_;
-    int no_result_requests_;
-    int current_time_;
+    const int64_t window_seconds_;
+    const Clock::time_point start_time_ = Clock::now();
+    // На одну корзину больше окна, чтобы очистка корзины новой секунды не задевала окно
+    const size_t bucket_count_;
+    const std::unique_ptr<SecondBucket[]> buckets_;
 
-    void AddRequest(int results_num);
+    int64_t GetSecond(Clock::time_point time) const;
+    // Возвращает корзину секунды second с учтённым писателем или nullptr, если секунда уже вытеснена
+    SecondBucket* AcquireBucket(int64_t second);
+    void AddRequest(Clock::time_point start_time, size_t results_num);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
-    RequestQueue::AddRequest(result.size());
+    return AddFindRequest(std::execution::par, raw_query, document_predicate);
+}
+
+template <typename Policy, typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(const Policy& policy, const std::string& raw_query, DocumentPredicate document_predicate) {
+    const auto start_time = Clock::now();
+    auto result = search_server_.FindTopDocuments(policy, raw_query, document_predicate);
+    AddRequest(start_time, result.size());
     return result;
-}
\ No newline at end of file
+}
+
+template <typename Policy>
+std::vector<Document> RequestQueue::AddFindRequest(const Policy& policy, const std::string& raw_query) {
+    return AddFindRequest(policy, raw_query, DocumentStatus::ACTUAL);
+}
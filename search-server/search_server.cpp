@@ -9,22 +9,152 @@ std::set<int>::const_iterator SearchServer::end() const {
 }
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-    if (document_id < 0 || (documents_.count(document_id) > 0)) {
+    if (document_id < 0 || (id_to_ordinal_.count(document_id) > 0)) {
         throw std::invalid_argument("SearchServer::AddDocument, invalid document id");
     }
-    words_.emplace_back(document);
-    const auto words = SplitIntoWordsNoStop(words_.back());
-    const double inv_word_count = 1.0 / words.size();
-    for (const std::string_view word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        word_to_document_freqs_by_id_[document_id][word] += inv_word_count;
+    const auto word_freqs = MeasureStage(MetricStage::DOCUMENT_TOKENIZE, [&] {
+        return ComputeWordFrequencies(document);
+    });
+    const StageTimer index_timer(MetricStage::DOCUMENT_INDEX);
+    const int document_ordinal = AllocateDocumentOrdinal(document_id);
+    auto& interned_word_freqs = document_word_freqs_[document_ordinal];
+    auto& term_ids = document_term_ids_[document_ordinal];
+    for (const auto [word, term_freq] : word_freqs) {
+        const int term_id = AcquireTerm(word);
+        term_postings_[term_id].Add(document_ordinal, term_freq);
+        UpdateDocumentFreq(term_id);
+        interned_word_freqs.emplace_hint(interned_word_freqs.end(), terms_.GetTerm(term_id), term_freq);
+        term_ids.push_back(term_id);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
+    std::sort(term_ids.begin(), term_ids.end());
+    SetDocumentData(document_ordinal, DocumentData{ document_id, ComputeAverageRating(ratings), status });
     sorted_document_id_.insert(document_id);
+    AddMetricCount(MetricCounter::DOCUMENTS_ADDED, 1);
+}
+
+IngestionStats SearchServer::AddDocuments(const std::vector<DocumentInput>& documents) {
+    return AddDocumentsImpl(std::execution::seq, documents);
+}
+
+IngestionStats SearchServer::AddDocuments(const std::execution::sequenced_policy& policy, const std::vector<DocumentInput>& documents) {
+    return AddDocumentsImpl(policy, documents);
+}
+
+IngestionStats SearchServer::AddDocuments(const std::execution::parallel_policy& policy, const std::vector<DocumentInput>& documents) {
+    return AddDocumentsImpl(policy, documents);
+}
+
+void SearchServer::ValidateNewDocumentIds(const std::vector<DocumentInput>& documents) const {
+    std::vector<int> document_ids;
+    document_ids.reserve(documents.size());
+    for (const DocumentInput& document : documents) {
+        if (document.id < 0 || id_to_ordinal_.count(document.id) > 0) {
+            throw std::invalid_argument("SearchServer::AddDocuments, invalid document id");
+        }
+        document_ids.push_back(document.id);
+    }
+    std::sort(document_ids.begin(), document_ids.end());
+    if (std::adjacent_find(document_ids.begin(), document_ids.end()) != document_ids.end()) {
+        throw std::invalid_argument("SearchServer::AddDocuments, duplicate document id");
+    }
+}
+
+template <typename Policy>
+IngestionStats SearchServer::AddDocumentsImpl(const Policy& policy, const std::vector<DocumentInput>& documents) {
+    const auto start_time = std::chrono::steady_clock::now();
+    ValidateNewDocumentIds(documents);
+
+    IngestionStats stats;
+    stats.document_count = documents.size();
+    for (const DocumentInput& document : documents) {
+        stats.byte_count += document.text.size();
+    }
+
+    // Исключение внутри параллельного алгоритма вызывает std::terminate,
+    // поэтому ошибки разбора запоминаются и обрабатываются после
+    std::vector<std::map<std::string_view, double>> word_freqs(documents.size());
+    std::vector<char> is_valid(documents.size(), true);
+    std::vector<size_t> indexes(documents.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    MeasureStage(MetricStage::DOCUMENT_TOKENIZE, [&] {
+        std::for_each(policy, indexes.begin(), indexes.end(),
+            [this, &documents, &word_freqs, &is_valid](size_t i) {
+                try {
+                    word_freqs[i] = ComputeWordFrequencies(documents[i].text);
+                }
+                catch (const std::invalid_argument&) {
+                    is_valid[i] = false;
+                }
+            });
+    });
+    if (std::find(is_valid.begin(), is_valid.end(), false) != is_valid.end()) {
+        throw std::invalid_argument("SearchServer::AddDocuments, invalid character(s)");
+    }
+    const StageTimer index_timer(MetricStage::DOCUMENT_INDEX);
+
+    std::vector<int> ordinals(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentInput& document = documents[i];
+        ordinals[i] = AllocateDocumentOrdinal(document.id);
+        SetDocumentData(ordinals[i], DocumentData{ document.id, ComputeAverageRating(document.ratings), document.status });
+        sorted_document_id_.insert(document.id);
+    }
+
+    // Каждый поток строит частичные списки вхождений для своей части пакета
+    const size_t chunk_count = std::max<size_t>(1, std::min<size_t>(documents.size(), std::thread::hardware_concurrency()));
+    const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+    std::vector<std::unordered_map<std::string_view, std::vector<Posting>>> chunk_postings(chunk_count);
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::for_each(policy, chunks.begin(), chunks.end(),
+        [&documents, &word_freqs, &ordinals, &chunk_postings, chunk_size](size_t chunk) {
+            const size_t last = std::min(documents.size(), (chunk + 1) * chunk_size);
+            for (size_t i = chunk * chunk_size; i < last; ++i) {
+                for (const auto [word, term_freq] : word_freqs[i]) {
+                    chunk_postings[chunk][word].push_back({ ordinals[i], term_freq });
+                }
+            }
+        });
+
+    // Словарь пополняется последовательно, после чего каждый список вхождений
+    // сливается с частичными списками за один проход
+    std::unordered_map<int, std::vector<const std::vector<Posting>*>> term_parts;
+    for (const auto& postings_by_word : chunk_postings) {
+        for (const auto& [word, postings] : postings_by_word) {
+            term_parts[AcquireTerm(word, static_cast<int>(postings.size()))].push_back(&postings);
+        }
+    }
+    std::vector<std::pair<int, std::vector<const std::vector<Posting>*>>> merges(term_parts.begin(), term_parts.end());
+    std::for_each(policy, merges.begin(), merges.end(),
+        [this](const std::pair<int, std::vector<const std::vector<Posting>*>>& merge) {
+            std::vector<Posting> postings;
+            for (const std::vector<Posting>* part : merge.second) {
+                postings.insert(postings.end(), part->begin(), part->end());
+            }
+            term_postings_[merge.first].Merge(std::move(postings));
+            UpdateDocumentFreq(merge.first);
+        });
+
+    // Ключи частот слов документа переводятся со входного текста на строки словаря
+    std::for_each(policy, indexes.begin(), indexes.end(),
+        [this, &word_freqs, &ordinals](size_t i) {
+            auto& interned_word_freqs = document_word_freqs_[ordinals[i]];
+            auto& term_ids = document_term_ids_[ordinals[i]];
+            for (const auto [word, term_freq] : word_freqs[i]) {
+                const int term_id = terms_.Find(word);
+                interned_word_freqs.emplace_hint(interned_word_freqs.end(), terms_.GetTerm(term_id), term_freq);
+                term_ids.push_back(term_id);
+            }
+            std::sort(term_ids.begin(), term_ids.end());
+        });
+
+    AddMetricCount(MetricCounter::DOCUMENTS_ADDED, documents.size());
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return stats;
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const {
-    return FindTopDocuments(raw_query, [filter_status](int document_id, DocumentStatus status, int rating) { return status == filter_status; });
+    return FindTopDocuments(std::execution::seq, raw_query, filter_status);
 }
 
 
@@ -32,9 +162,53 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
     return SearchServer::FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+SearchPage SearchServer::FindDocumentsPage(const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus filter_status) const {
+    return FindDocumentsPage(std::execution::seq, raw_query, cursor, page_size, filter_status);
+}
+
 
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return id_to_ordinal_.size();
+}
+
+void SearchServer::SetMaxResultDocumentCount(int count) {
+    if (count < 0) {
+        throw std::invalid_argument("SearchServer::SetMaxResultDocumentCount, negative count");
+    }
+    max_result_document_count_ = count;
+    ++index_generation_;
+}
+
+int SearchServer::GetMaxResultDocumentCount() const {
+    return max_result_document_count_;
+}
+
+void SearchServer::SetPostingEncoding(PostingEncoding encoding) {
+    posting_encoding_ = encoding;
+    ++index_generation_;
+    for (PostingList& postings : term_postings_) {
+        postings.SetEncoding(encoding);
+    }
+}
+
+PostingEncoding SearchServer::GetPostingEncoding() const {
+    return posting_encoding_;
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity) {
+    query_cache_.SetCapacity(capacity);
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const {
+    return query_cache_.GetStats();
+}
+
+size_t SearchServer::GetPostingsMemoryUsage() const {
+    size_t bytes = term_postings_.capacity() * sizeof(PostingList);
+    for (const PostingList& postings : term_postings_) {
+        bytes += postings.GetMemoryUsage();
+    }
+    return bytes;
 }
 
 using MatchDocumentFn = std::tuple<std::vector<std::string_view>, DocumentStatus>;
@@ -42,25 +216,29 @@ using MatchDocumentFn = std::tuple<std::vector<std::string_view>, DocumentStatus
 MatchDocumentFn SearchServer::MatchDocument(const std::string_view raw_query, int document_id) const {
 
     const SearchServer::Query query = SearchServer::ParseQuery(raw_query);
+    const int document_ordinal = GetDocumentOrdinal(document_id);
+    const DocumentStatus status = documents_[document_ordinal].status;
 
     std::vector<std::string_view> matched_words;
     for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        const int term_id = terms_.Find(word);
+        if (term_id == NO_TERM) {
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+        if (term_postings_[term_id].Contains(document_ordinal)) {
+            return { std::vector<std::string_view>{}, status };
         }
     }
     for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        const int term_id = terms_.Find(word);
+        if (term_id == NO_TERM) {
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        if (term_postings_[term_id].Contains(document_ordinal)) {
             matched_words.push_back(word);
         }
     }
-    return tie(matched_words, documents_.at(document_id).status);
+    return tie(matched_words, status);
 }
 
 MatchDocumentFn SearchServer::MatchDocument(const std::execution::sequenced_policy& policy, const std::string_view raw_query, int document_id) const {
@@ -69,11 +247,14 @@ MatchDocumentFn SearchServer::MatchDocument(const std::execution::sequenced_poli
 
 MatchDocumentFn SearchServer::MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query, int document_id) const {
     const SearchServer::Query query = SearchServer::ParseQuery(raw_query);
+    const int document_ordinal = GetDocumentOrdinal(document_id);
+    const auto& word_freqs = document_word_freqs_[document_ordinal];
+    const DocumentStatus status = documents_[document_ordinal].status;
     if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const std::string_view word) {
-            return word_to_document_freqs_by_id_.at(document_id).count(word) > 0;
+        [&word_freqs](const std::string_view word) {
+            return word_freqs.count(word) > 0;
         })) {
-        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+        return { std::vector<std::string_view>{}, status };
     };
 
     std::vector<std::string_view> matched_words(query.plus_words.size());
@@ -82,20 +263,191 @@ MatchDocumentFn SearchServer::MatchDocument(const std::execution::parallel_polic
         query.plus_words.begin(),
         query.plus_words.end(),
         matched_words.begin(),
-        [this, document_id](const std::string_view word) {
-            return word_to_document_freqs_by_id_.at(document_id).count(word) > 0;
+        [&word_freqs](const std::string_view word) {
+            return word_freqs.count(word) > 0;
         });
     std::sort(policy, matched_words.begin(), it);
     it = std::unique(policy, matched_words.begin(), it);
     matched_words.erase(it, matched_words.end());
-    return tie(matched_words, documents_.at(document_id).status);
+    return tie(matched_words, status);
+}
+
+DocumentMatches SearchServer::MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids) const {
+    DocumentMatches matches;
+    MatchDocumentsImpl(std::execution::seq, raw_query, document_ids, matches);
+    return matches;
+}
+
+void SearchServer::MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    MatchDocumentsImpl(std::execution::seq, raw_query, document_ids, matches);
+}
+
+void SearchServer::MatchDocuments(const std::execution::sequenced_policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    MatchDocumentsImpl(policy, raw_query, document_ids, matches);
+}
+
+void SearchServer::MatchDocuments(const std::execution::parallel_policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    MatchDocumentsImpl(policy, raw_query, document_ids, matches);
+}
+
+template <typename Policy>
+void SearchServer::MatchDocumentsImpl(const Policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    const Query query = ParseQuery(raw_query);
+    // Слова запроса переводятся в идентификаторы и сортируются, чтобы пересекать их
+    // с отсортированными идентификаторами слов документа одним слиянием
+    std::vector<int> plus_term_ids;
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != NO_TERM) {
+            plus_term_ids.push_back(term_id);
+        }
+    }
+    std::sort(plus_term_ids.begin(), plus_term_ids.end());
+    std::vector<int> minus_term_ids;
+    for (const std::string_view word : query.minus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != NO_TERM) {
+            minus_term_ids.push_back(term_id);
+        }
+    }
+    std::sort(minus_term_ids.begin(), minus_term_ids.end());
+
+    // Неизвестный id бросает out_of_range до параллельной части
+    const size_t document_count = document_ids.size();
+    std::vector<int> ordinals(document_count);
+    matches.statuses.resize(document_count);
+    for (size_t i = 0; i < document_count; ++i) {
+        ordinals[i] = GetDocumentOrdinal(document_ids[i]);
+        matches.statuses[i] = documents_[ordinals[i]].status;
+    }
+
+    // Каждый документ пишет слова в свой участок из plus_term_ids.size() ячеек
+    // и число слов в offsets[i + 1]; затем участки сдвигаются вплотную
+    const size_t stride = plus_term_ids.size();
+    matches.words.resize(document_count * stride);
+    matches.offsets.assign(document_count + 1, 0);
+    std::vector<size_t> indexes(document_count);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(policy, indexes.begin(), indexes.end(),
+        [this, &ordinals, &plus_term_ids, &minus_term_ids, &matches, stride](size_t i) {
+            const std::vector<int>& term_ids = document_term_ids_[ordinals[i]];
+            auto term_it = term_ids.begin();
+            for (const int term_id : minus_term_ids) {
+                term_it = std::lower_bound(term_it, term_ids.end(), term_id);
+                if (term_it == term_ids.end()) {
+                    break;
+                }
+                if (*term_it == term_id) {
+                    return;
+                }
+            }
+
+            const auto first_word = matches.words.begin() + i * stride;
+            auto word_it = first_word;
+            term_it = term_ids.begin();
+            for (const int term_id : plus_term_ids) {
+                term_it = std::lower_bound(term_it, term_ids.end(), term_id);
+                if (term_it == term_ids.end()) {
+                    break;
+                }
+                if (*term_it == term_id) {
+                    *word_it++ = terms_.GetTerm(term_id);
+                }
+            }
+            std::sort(first_word, word_it);
+            matches.offsets[i + 1] = word_it - first_word;
+        });
+
+    size_t word_count = 0;
+    for (size_t i = 0; i < document_count; ++i) {
+        const auto first_word = matches.words.begin() + i * stride;
+        const size_t document_word_count = matches.offsets[i + 1];
+        std::copy(first_word, first_word + document_word_count, matches.words.begin() + word_count);
+        word_count += document_word_count;
+        matches.offsets[i + 1] = word_count;
+    }
+    matches.words.resize(word_count);
 }
 
 bool SearchServer::IsStopWord(const std::string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
+int SearchServer::AcquireTerm(const std::string_view word, int references) {
+    const int term_id = terms_.Acquire(word, references);
+    if (term_postings_.size() < terms_.GetIdBound()) {
+        term_postings_.resize(terms_.GetIdBound(), PostingList(posting_encoding_));
+        term_log_document_freqs_.resize(terms_.GetIdBound());
+    }
+    return term_id;
+}
+
+void SearchServer::ReleaseTerm(int term_id) {
+    if (terms_.Release(term_id)) {
+        term_postings_[term_id] = PostingList(posting_encoding_);
+    }
+}
+
+void SearchServer::UpdateDocumentFreq(int term_id) {
+    const size_t document_freq = term_postings_[term_id].size();
+    term_log_document_freqs_[term_id] = document_freq > 0 ? log(static_cast<double>(document_freq)) : 0.0;
+}
+
+void SearchServer::UpdateDocumentCount() {
+    log_document_count_ = id_to_ordinal_.empty() ? 0.0 : log(static_cast<double>(id_to_ordinal_.size()));
+}
+
+int SearchServer::GetDocumentOrdinal(int document_id) const {
+    return id_to_ordinal_.at(document_id);
+}
+
+int SearchServer::AllocateDocumentOrdinal(int document_id) {
+    int document_ordinal;
+    if (free_ordinals_.empty()) {
+        document_ordinal = static_cast<int>(documents_.size());
+        documents_.push_back({ NO_DOCUMENT, 0, DocumentStatus::REMOVED });
+        document_word_freqs_.emplace_back();
+        document_term_ids_.emplace_back();
+    }
+    else {
+        document_ordinal = free_ordinals_.back();
+        free_ordinals_.pop_back();
+    }
+    id_to_ordinal_.emplace(document_id, document_ordinal);
+    UpdateDocumentCount();
+    ++index_generation_;
+    return document_ordinal;
+}
+
+void SearchServer::ReleaseDocumentOrdinal(int document_ordinal) {
+    id_to_ordinal_.erase(documents_[document_ordinal].id);
+    UpdateDocumentCount();
+    ++index_generation_;
+    SetDocumentData(document_ordinal, DocumentData{ NO_DOCUMENT, 0, DocumentStatus::REMOVED });
+    document_word_freqs_[document_ordinal].clear();
+    document_term_ids_[document_ordinal].clear();
+    free_ordinals_.push_back(document_ordinal);
+}
+
+void SearchServer::SetDocumentData(int document_ordinal, const DocumentData& document_data) {
+    const size_t word_count = (documents_.size() + 63) / 64;
+    if (status_bitmaps_[0].size() < word_count) {
+        for (auto& bitmap : status_bitmaps_) {
+            bitmap.resize(word_count);
+        }
+    }
+    const uint64_t bit = uint64_t{ 1 } << (document_ordinal % 64);
+    DocumentData& old_data = documents_[document_ordinal];
+    if (old_data.id != NO_DOCUMENT) {
+        status_bitmaps_[static_cast<int>(old_data.status)][document_ordinal / 64] &= ~bit;
+    }
+    if (document_data.id != NO_DOCUMENT) {
+        status_bitmaps_[static_cast<int>(document_data.status)][document_ordinal / 64] |= bit;
+    }
+    old_data = document_data;
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, const StopWords& stop_words) {
     bool is_minus = false;
     if (text[0] == '-') {
         is_minus = true;
@@ -104,16 +456,21 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
             throw std::invalid_argument("empty or incorrect minus word");
         }
     }
-    return { text, is_minus, SearchServer::IsStopWord(text) };
+    return { text, is_minus, stop_words.Contains(text) };
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const {
+    return ParseQuery(text, stop_words_);
+}
+
+SearchServer::Query SearchServer::ParseQuery(const std::string_view text, const StopWords& stop_words) {
+    thread_local std::vector<std::string_view> words;
+    if (!SplitIntoWords(text, words)) {
+        throw std::invalid_argument("invalid character(s)");
+    }
     Query query;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("invalid character(s)");
-        }
-        const QueryWord query_word = ParseQueryWord(word);
+    for (const std::string_view word : words) {
+        const QueryWord query_word = ParseQueryWord(word, stop_words);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 query.minus_words.push_back(query_word.data);
@@ -128,48 +485,165 @@ SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
     return query;
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const {
-    std::vector<std::string_view> words;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        if (!SearchServer::IsStopWord(word)) {
-            if (!SearchServer::IsValidWord(word)) {
-                throw std::invalid_argument("invalid character(s)");
-            }
-            words.emplace_back(word);
+std::string SearchServer::MakeQueryCacheKey(const Query& query, DocumentStatus filter_status) {
+    // Слова не содержат управляющих символов, поэтому они служат разделителями
+    std::string key;
+    for (const std::string_view word : query.plus_words) {
+        key += word;
+        key += '\x01';
+    }
+    key += '\x02';
+    for (const std::string_view word : query.minus_words) {
+        key += word;
+        key += '\x01';
+    }
+    key += '\x02';
+    key += std::to_string(static_cast<int>(filter_status));
+    return key;
+}
+
+void SearchServer::SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const {
+    if (!SplitIntoWords(text, words)) {
+        throw std::invalid_argument("invalid character(s)");
+    }
+    words.erase(std::remove_if(words.begin(), words.end(), [this](const std::string_view word) {
+        return IsStopWord(word);
+    }), words.end());
+}
+
+std::map<std::string_view, double> SearchServer::ComputeWordFrequencies(const std::string_view text) const {
+    // Буфер слов свой у каждого потока, поэтому пакетное добавление не выделяет его заново
+    thread_local std::vector<std::string_view> words;
+    SplitIntoWordsNoStop(text, words);
+    const double inv_word_count = 1.0 / words.size();
+    std::map<std::string_view, double> word_freqs;
+    for (const std::string_view word : words) {
+        word_freqs[word] += inv_word_count;
+    }
+    return word_freqs;
+}
+
+double SearchServer::ComputeTermInverseDocumentFreq(int term_id) const {
+    return log_document_count_ - term_log_document_freqs_[term_id];
+}
+
+SearchServer::QueryTerms SearchServer::ResolveQueryTerms(const Query& query) const {
+    QueryTerms terms;
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != NO_TERM) {
+            terms.plus_terms.push_back({ &term_postings_[term_id], ComputeTermInverseDocumentFreq(term_id) });
+        }
+    }
+    for (const std::string_view word : query.minus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != NO_TERM) {
+            terms.minus_terms.push_back(&term_postings_[term_id]);
         }
     }
-    return words;
+    PlanQueryTerms(terms);
+    return terms;
+}
+
+SearchServer::QueryTerms SearchServer::ResolveQueryTerms(const Query& query, const std::vector<double>& inverse_document_freqs) const {
+    QueryTerms terms;
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const int term_id = terms_.Find(query.plus_words[i]);
+        if (term_id != NO_TERM) {
+            terms.plus_terms.push_back({ &term_postings_[term_id], inverse_document_freqs[i] });
+        }
+    }
+    for (const std::string_view word : query.minus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != NO_TERM) {
+            terms.minus_terms.push_back(&term_postings_[term_id]);
+        }
+    }
+    PlanQueryTerms(terms);
+    return terms;
+}
+
+void SearchServer::PlanQueryTerms(QueryTerms& terms) {
+    const auto is_universal = [](const ScoredTerm& term) {
+        return term.inverse_document_freq == 0.0;
+    };
+    terms.matches_all_documents = std::any_of(terms.plus_terms.begin(), terms.plus_terms.end(), is_universal);
+    terms.plus_terms.erase(std::remove_if(terms.plus_terms.begin(), terms.plus_terms.end(), is_universal), terms.plus_terms.end());
+    // Слова запроса отсортированы, поэтому при равных IDF порядок одинаков на всех шардах
+    std::stable_sort(terms.plus_terms.begin(), terms.plus_terms.end(), [](const ScoredTerm& lhs, const ScoredTerm& rhs) {
+        return lhs.inverse_document_freq > rhs.inverse_document_freq;
+    });
+}
+
+int SearchServer::GetDocumentFreq(const std::string_view word) const {
+    const int term_id = terms_.Find(word);
+    return term_id == NO_TERM ? 0 : static_cast<int>(term_postings_[term_id].size());
+}
+
+void SearchServer::SelectTopDocuments(const std::execution::sequenced_policy& policy, std::vector<Document>& documents) const {
+    SelectTopDocuments(policy, documents, static_cast<size_t>(max_result_document_count_));
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const {
-    return log(SearchServer::GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+void SearchServer::SelectTopDocuments(const std::execution::parallel_policy& policy, std::vector<Document>& documents) const {
+    SelectTopDocuments(policy, documents, static_cast<size_t>(max_result_document_count_));
+}
+
+void SearchServer::SelectTopDocuments(const std::execution::sequenced_policy& policy, std::vector<Document>& documents, size_t count) const {
+    count = std::min(documents.size(), count);
+    std::partial_sort(documents.begin(), documents.begin() + count, documents.end(), IsRankedHigher);
+    documents.resize(count);
+}
+
+void SearchServer::SelectTopDocuments(const std::execution::parallel_policy& policy, std::vector<Document>& documents, size_t count) const {
+    const size_t chunk_count = std::max(1u, std::thread::hardware_concurrency());
+    if (documents.size() <= count * chunk_count) {
+        return SelectTopDocuments(std::execution::seq, documents, count);
+    }
+
+    // Каждый поток выбирает лучшие документы в своей части, затем части сливаются
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+    std::for_each(policy, chunks.begin(), chunks.end(),
+        [&documents, count, chunk_size](size_t chunk) {
+            const auto first = documents.begin() + std::min(documents.size(), chunk * chunk_size);
+            const auto last = documents.begin() + std::min(documents.size(), (chunk + 1) * chunk_size);
+            std::partial_sort(first, first + std::min(count, static_cast<size_t>(last - first)), last, IsRankedHigher);
+        });
+
+    std::vector<Document> candidates;
+    candidates.reserve(count * chunk_count);
+    for (const size_t chunk : chunks) {
+        const auto first = documents.begin() + std::min(documents.size(), chunk * chunk_size);
+        const auto last = documents.begin() + std::min(documents.size(), (chunk + 1) * chunk_size);
+        candidates.insert(candidates.end(), first, first + std::min(count, static_cast<size_t>(last - first)));
+    }
+    documents = std::move(candidates);
+    SelectTopDocuments(std::execution::seq, documents, count);
 }
 
 const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (word_to_document_freqs_by_id_.count(document_id) > 0) {
-        return word_to_document_freqs_by_id_.at(document_id);
+    const auto it = id_to_ordinal_.find(document_id);
+    if (it != id_to_ordinal_.end()) {
+        return document_word_freqs_[it->second];
     }
     static const std::map<std::string_view, double> empty_map;
     return empty_map;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-    if (documents_.count(document_id) == 0) {
+    const auto it = id_to_ordinal_.find(document_id);
+    if (it == id_to_ordinal_.end()) {
         return;
     }
-    documents_.erase(document_id);
+    const int document_ordinal = it->second;
     sorted_document_id_.erase(document_id);
-    auto word_freq = GetWordFrequencies(document_id);
-    if (word_freq.empty()) {
-        return;
+    for (const int term_id : document_term_ids_[document_ordinal]) {
+        term_postings_[term_id].Erase(document_ordinal);
+        UpdateDocumentFreq(term_id);
+        ReleaseTerm(term_id);
     }
-    for (const auto& [word, freq] : word_freq) {
-        word_to_document_freqs_[word].erase(document_id);
-        if (word_to_document_freqs_[word].empty()) {
-            word_to_document_freqs_.erase(word);
-        }
-    }
-    word_to_document_freqs_by_id_.erase(document_id);
+    ReleaseDocumentOrdinal(document_ordinal);
 }
 
 void SearchServer::RemoveDocument(const std::execution::sequenced_policy& policy, int document_id) {
@@ -177,27 +651,24 @@ void SearchServer::RemoveDocument(const std::execution::sequenced_policy& policy
 }
 
 void SearchServer::RemoveDocument(const std::execution::parallel_policy& policy, int document_id) {
-    if (documents_.count(document_id) == 0) {
+    const auto it = id_to_ordinal_.find(document_id);
+    if (it == id_to_ordinal_.end()) {
         return;
     }
-    documents_.erase(document_id);
+    const int document_ordinal = it->second;
     sorted_document_id_.erase(document_id);
-    const std::map<std::string_view, double>& doc_to_freq = word_to_document_freqs_by_id_.at(document_id);
-    std::vector<const std::string_view*> words(doc_to_freq.size());
-    std::transform(policy,
-        doc_to_freq.begin(),
-        doc_to_freq.end(),
-        words.begin(),
-        [](const std::pair<const std::string_view, double>& word_to_freq) {
-            return &word_to_freq.first;
-        });
+    const std::vector<int>& term_ids = document_term_ids_[document_ordinal];
     std::for_each(policy,
-        words.begin(),
-        words.end(),
-        [this, document_id](const std::string_view* del) {
-            word_to_document_freqs_[*del].erase(document_id);
+        term_ids.begin(),
+        term_ids.end(),
+        [this, document_ordinal](int term_id) {
+            term_postings_[term_id].Erase(document_ordinal);
+            UpdateDocumentFreq(term_id);
         });
-    word_to_document_freqs_by_id_.erase(document_id);
+    for (const int term_id : term_ids) {
+        ReleaseTerm(term_id);
+    }
+    ReleaseDocumentOrdinal(document_ordinal);
 }
 
 void SearchServer::Query::EraseDuplicates(std::vector<std::string_view>& words) {
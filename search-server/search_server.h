@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <map>
 #include <stdexcept>
 #include <algorithm>
@@ -8,16 +9,91 @@
 #include <string_view>
 #include <vector>
 #include <execution>
+#include <limits>
+#include <queue>
 #include <set>
-#include <deque>
-
-#include "concurrent_map.h"
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <type_traits>
+
+#include "posting_list.h"
+#include "query_cache.h"
+#include "stop_words.h"
+#include "term_dictionary.h"
 #include "string_processing.h"
 #include "document.h"
+#include "document_filter.h"
+#include "metrics.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
 
+// Порядок выдачи: по убыванию релевантности, при равенстве с точностью до EPSILON —
+// по убыванию рейтинга, затем по возрастанию id.
+inline bool IsRankedHigher(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+struct DocumentInput {
+    int id;
+    std::string_view text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+struct IngestionStats {
+    size_t document_count = 0;
+    size_t byte_count = 0;
+    double seconds = 0.0;
+
+    double GetDocumentsPerSecond() const {
+        return seconds > 0.0 ? document_count / seconds : 0.0;
+    }
+
+    double GetMegabytesPerSecond() const {
+        return seconds > 0.0 ? byte_count / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+// Результат MatchDocuments: слова запроса, найденные в i-м документе, лежат в
+// words[offsets[i], offsets[i + 1]) в алфавитном порядке, статус документа — statuses[i].
+// Слова указывают на строки словаря сервера
+struct DocumentMatches {
+    std::vector<std::string_view> words;
+    std::vector<size_t> offsets;
+    std::vector<DocumentStatus> statuses;
+
+    size_t size() const {
+        return statuses.size();
+    }
+};
+
+// Позиция в выдаче для постраничного поиска: последний документ предыдущей страницы.
+// Курсор по умолчанию указывает на начало выдачи
+struct SearchCursor {
+    double relevance = 0.0;
+    int rating = 0;
+    int id = -1;
+
+    bool IsStart() const {
+        return id < 0;
+    }
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    // Курсор для запроса следующей страницы
+    SearchCursor next_cursor;
+    bool has_more = false;
+};
+
 class SearchServer {
 public:
 
@@ -34,6 +110,12 @@ public:
 
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Пакетное добавление: результат тот же, что у последовательных вызовов AddDocument,
+    // но при ошибке в любом документе индекс не изменяется
+    IngestionStats AddDocuments(const std::vector<DocumentInput>& documents);
+    IngestionStats AddDocuments(const std::execution::sequenced_policy& policy, const std::vector<DocumentInput>& documents);
+    IngestionStats AddDocuments(const std::execution::parallel_policy& policy, const std::vector<DocumentInput>& documents);
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate, typename Policy>
@@ -47,9 +129,34 @@ public:
     template <typename Policy>
     std::vector<Document> FindTopDocuments(const Policy& policy, const std::string_view raw_query) const;
 
+    // Следующие page_size документов выдачи после cursor в порядке FindTopDocuments.
+    // Ограничение GetMaxResultDocumentCount не действует; вычисляются только документы страницы
+    template <typename DocumentPredicate>
+    SearchPage FindDocumentsPage(const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename Policy>
+    SearchPage FindDocumentsPage(const Policy& policy, const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
+
+    SearchPage FindDocumentsPage(const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus filter_status = DocumentStatus::ACTUAL) const;
+    template <typename Policy>
+    SearchPage FindDocumentsPage(const Policy& policy, const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus filter_status = DocumentStatus::ACTUAL) const;
+
 
     int GetDocumentCount() const;
 
+    void SetMaxResultDocumentCount(int count);
+    int GetMaxResultDocumentCount() const;
+
+    // Перекодирует все списки вхождений; новые слова получают ту же кодировку.
+    // В COMPRESSED частоты хранятся в float, релевантность совпадает с PLAIN до ~1e-7
+    void SetPostingEncoding(PostingEncoding encoding);
+    PostingEncoding GetPostingEncoding() const;
+    size_t GetPostingsMemoryUsage() const;
+
+    // Кеш результатов FindTopDocuments с фильтром по статусу; ёмкость 0 отключает кеш.
+    // Любое изменение индекса делает прежние записи недействительными
+    void SetQueryCacheCapacity(size_t capacity);
+    QueryCacheStats GetQueryCacheStats() const;
+
     std::set<int>::const_iterator begin() const;
     std::set<int>::const_iterator end() const;
 
@@ -59,34 +166,90 @@ public:
     MatchDocumentFn MatchDocument(const std::execution::sequenced_policy& policy, const std::string_view raw_query, int document_id) const;
     MatchDocumentFn MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query, int document_id) const;
 
+    // То же, что MatchDocument для каждого id, но запрос разбирается один раз.
+    // Буферы matches переиспользуются, поэтому при повторных вызовах память не выделяется
+    DocumentMatches MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids) const;
+    void MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const;
+    void MatchDocuments(const std::execution::sequenced_policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const;
+    void MatchDocuments(const std::execution::parallel_policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const;
+
     const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy& policy, int document_id);
     void RemoveDocument(const std::execution::parallel_policy& policy, int document_id);
 
+    // Бинарный снимок индекса, формат описан в index_snapshot.h
+    void SaveSnapshot(const std::string& path) const;
+    static SearchServer LoadSnapshot(const std::string& path);
+
 private:
     struct DocumentData {
+        int id;
         int rating;
         DocumentStatus status;
     };
-    
-    std::deque<std::string> words_;
-    std::set<std::string, std::less<>> const stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> word_to_document_freqs_by_id_;
-    std::map<int, DocumentData> documents_;
+
+    static constexpr int NO_TERM = TermDictionary::NO_TERM;
+    static constexpr int NO_DOCUMENT = -1;
+
+    using StopWords = StopWordSet;
+
+    StopWords const stop_words_;
+    TermDictionary terms_;
+    std::vector<PostingList> term_postings_;
+    // IDF слова равен log_document_count_ - term_log_document_freqs_[term_id];
+    // оба логарифма обновляются при изменении индекса, а не при каждом запросе
+    std::vector<double> term_log_document_freqs_;
+    double log_document_count_ = 0.0;
+    std::unordered_map<int, int> id_to_ordinal_;
+    std::vector<DocumentData> documents_;
+    // Бит порядкового номера документа установлен в маске его статуса
+    std::array<std::vector<uint64_t>, DOCUMENT_STATUS_COUNT> status_bitmaps_;
+    std::vector<std::map<std::string_view, double>> document_word_freqs_;
+    // Отсортированные идентификаторы слов документа
+    std::vector<std::vector<int>> document_term_ids_;
+    std::vector<int> free_ordinals_;
     std::set<int> sorted_document_id_;
+    int max_result_document_count_ = MAX_RESULT_DOCUMENT_COUNT;
+    PostingEncoding posting_encoding_ = PostingEncoding::PLAIN;
+    // Увеличивается при каждом изменении, влияющем на выдачу
+    uint64_t index_generation_ = 0;
+    mutable QueryResultCache query_cache_;
 
     bool IsStopWord(const std::string_view word) const;
 
+    int AcquireTerm(const std::string_view word, int references = 1);
+    void ReleaseTerm(int term_id);
+    void UpdateDocumentFreq(int term_id);
+    void UpdateDocumentCount();
+
+    int GetDocumentOrdinal(int document_id) const;
+    int AllocateDocumentOrdinal(int document_id);
+    void ReleaseDocumentOrdinal(int document_ordinal);
+    void SetDocumentData(int document_ordinal, const DocumentData& document_data);
+
+    // Возвращает функцию int document_ordinal -> bool. DocumentFilter проверяется по маскам
+    // статусов (status_words — хранилище для объединения нескольких масок), остальные
+    // предикаты вызываются с данными документа
+    template <typename DocumentPredicate>
+    auto MakeDocumentAcceptor(const DocumentPredicate& document_predicate, std::vector<uint64_t>& status_words) const;
+
     static bool IsValidWord(const std::string_view word) {
         return std::none_of(word.begin(), word.end(), [](char c) {
             return c >= '\0' && c < ' ';
             });
     }
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    // Записывает в words слова текста без стоп-слов; бросает invalid_argument при управляющих символах
+    void SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const;
+    std::map<std::string_view, double> ComputeWordFrequencies(const std::string_view text) const;
+
+    void ValidateNewDocumentIds(const std::vector<DocumentInput>& documents) const;
+    template <typename Policy>
+    void MatchDocumentsImpl(const Policy& policy, const std::string_view raw_query, const std::vector<int>& document_ids, DocumentMatches& matches) const;
+    template <typename Policy>
+    IngestionStats AddDocumentsImpl(const Policy& policy, const std::vector<DocumentInput>& documents);
 
     static int ComputeAverageRating(const std::vector<int>& ratings) {
         if (ratings.empty()) {
@@ -103,7 +266,7 @@ private:
 
     };
 
-    SearchServer::QueryWord ParseQueryWord(std::string_view text) const;
+    static QueryWord ParseQueryWord(std::string_view text, const StopWords& stop_words);
 
     struct Query {
         std::vector<std::string_view> plus_words;
@@ -115,15 +278,63 @@ private:
     };
 
     Query ParseQuery(const std::string_view text) const;
+    static Query ParseQuery(const std::string_view text, const StopWords& stop_words);
+    // Ключ кеша: отсортированные плюс- и минус-слова и статус
+    static std::string MakeQueryCacheKey(const Query& query, DocumentStatus filter_status);
+
+    double ComputeTermInverseDocumentFreq(int term_id) const;
+
+    struct ScoredTerm {
+        const PostingList* postings;
+        double inverse_document_freq;
+    };
+
+    // План запроса: плюс-слова идут по убыванию IDF, то есть от коротких списков к длинным.
+    // Слова с нулевым IDF есть во всех документах и ничего не добавляют к релевантности,
+    // поэтому вместо их списков выставляется matches_all_documents
+    struct QueryTerms {
+        std::vector<ScoredTerm> plus_terms;
+        std::vector<const PostingList*> minus_terms;
+        bool matches_all_documents = false;
+    };
 
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    QueryTerms ResolveQueryTerms(const Query& query) const;
+    // inverse_document_freqs[i] — заранее вычисленный IDF для query.plus_words[i]
+    QueryTerms ResolveQueryTerms(const Query& query, const std::vector<double>& inverse_document_freqs) const;
+    static void PlanQueryTerms(QueryTerms& terms);
+    int GetDocumentFreq(const std::string_view word) const;
+
+    void SelectTopDocuments(const std::execution::sequenced_policy& policy, std::vector<Document>& documents) const;
+    void SelectTopDocuments(const std::execution::parallel_policy& policy, std::vector<Document>& documents) const;
+    void SelectTopDocuments(const std::execution::sequenced_policy& policy, std::vector<Document>& documents, size_t count) const;
+    void SelectTopDocuments(const std::execution::parallel_policy& policy, std::vector<Document>& documents, size_t count) const;
+
+    // Отбираемая часть выдачи: count лучших документов среди тех, что идут после after
+    struct ResultWindow {
+        size_t count;
+        const Document* after = nullptr;
+    };
 
+    // Отбор кандидатов в top-K по алгоритму MaxScore: документ не оценивается до конца,
+    // если верхняя граница его релевантности ниже K-го найденного результата больше чем на EPSILON.
+    // Среди кандидатов гарантированно есть все документы, которые вернул бы полный перебор,
+    // а их релевантность суммируется в порядке слов плана запроса, как и в MappedSearchServer
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    void ScoreTopDocumentRange(const QueryTerms& terms, int first_ordinal, int last_ordinal, DocumentPredicate document_predicate, const ResultWindow& window, std::vector<Document>& candidates) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopCandidates(const std::execution::sequenced_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopCandidates(const std::execution::parallel_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopCandidates(const std::execution::sequenced_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate, const ResultWindow& window) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopCandidates(const std::execution::parallel_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate, const ResultWindow& window) const;
+
+    friend class ShardedSearchServer;
+    friend class MappedSearchServer;
+    friend class DuplicateFinder;
+    friend class QueryBatchEngine;
 };
 
 template <typename DocumentPredicate>
@@ -133,27 +344,43 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 
 template <typename DocumentPredicate, typename Policy>
 std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const Query query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
+    AddMetricCount(MetricCounter::QUERIES, 1);
+    const Query query = MeasureStage(MetricStage::QUERY_PARSE, [&] {
+        return ParseQuery(raw_query);
+    });
+    auto matched_documents = MeasureStage(MetricStage::QUERY_SCORE, [&] {
+        return FindTopCandidates(policy, ResolveQueryTerms(query), document_predicate);
+    });
+    MeasureStage(MetricStage::QUERY_TOP_K, [&] {
+        SelectTopDocuments(policy, matched_documents);
+    });
     return matched_documents;
 }
 
 template<typename Policy>
 std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentStatus filter_status) const {
-    return FindTopDocuments(policy, raw_query, [filter_status](int document_id, DocumentStatus status, int rating) { return status == filter_status; });
+    const DocumentFilter document_predicate(filter_status);
+    if (query_cache_.GetCapacity() == 0) {
+        return FindTopDocuments(policy, raw_query, document_predicate);
+    }
+
+    AddMetricCount(MetricCounter::QUERIES, 1);
+    const Query query = MeasureStage(MetricStage::QUERY_PARSE, [&] {
+        return ParseQuery(raw_query);
+    });
+    std::string key = MakeQueryCacheKey(query, filter_status);
+    std::vector<Document> matched_documents;
+    if (query_cache_.Find(key, index_generation_, matched_documents)) {
+        return matched_documents;
+    }
+    matched_documents = MeasureStage(MetricStage::QUERY_SCORE, [&] {
+        return FindTopCandidates(policy, ResolveQueryTerms(query), document_predicate);
+    });
+    MeasureStage(MetricStage::QUERY_TOP_K, [&] {
+        SelectTopDocuments(policy, matched_documents);
+    });
+    query_cache_.Insert(std::move(key), index_generation_, matched_documents);
+    return matched_documents;
 }
 
 template<typename Policy>
@@ -161,93 +388,278 @@ std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy, const
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindDocumentsPage(const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    return FindDocumentsPage(std::execution::seq, raw_query, cursor, page_size, document_predicate);
+}
+
+template <typename DocumentPredicate, typename Policy>
+SearchPage SearchServer::FindDocumentsPage(const Policy& policy, const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    if (page_size == 0) {
+        throw std::invalid_argument("SearchServer::FindDocumentsPage, page size must be positive");
+    }
+    AddMetricCount(MetricCounter::QUERIES, 1);
+    const Query query = MeasureStage(MetricStage::QUERY_PARSE, [&] {
+        return ParseQuery(raw_query);
+    });
+    // Лишний документ показывает, есть ли следующая страница. Страница не длиннее числа
+    // документов, поэтому огромный page_size ограничивается им, и page_size + 1 не переполняется
+    const Document after(cursor.id, cursor.relevance, cursor.rating);
+    const ResultWindow window{ std::min(page_size, documents_.size()) + 1, cursor.IsStart() ? nullptr : &after };
+    SearchPage page;
+    page.documents = MeasureStage(MetricStage::QUERY_SCORE, [&] {
+        return FindTopCandidates(policy, ResolveQueryTerms(query), document_predicate, window);
+    });
+    MeasureStage(MetricStage::QUERY_TOP_K, [&] {
+        SelectTopDocuments(policy, page.documents, window.count);
+    });
+    page.has_more = page.documents.size() > page_size;
+    if (page.has_more) {
+        page.documents.pop_back();
+    }
+    if (page.documents.empty()) {
+        page.next_cursor = cursor;
+    }
+    else {
+        const Document& last = page.documents.back();
+        page.next_cursor = { last.relevance, last.rating, last.id };
+    }
+    return page;
+}
+
+template <typename Policy>
+SearchPage SearchServer::FindDocumentsPage(const Policy& policy, const std::string_view raw_query, const SearchCursor& cursor, size_t page_size, DocumentStatus filter_status) const {
+    return FindDocumentsPage(policy, raw_query, cursor, page_size, DocumentFilter(filter_status));
+}
+
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+    : stop_words_(stop_words) {
     if (!std::all_of(stop_words.begin(), stop_words.end(), IsValidWord)) {
         throw std::invalid_argument("SearchServer (constructor): invalid stop word");
     }
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+void SearchServer::ScoreTopDocumentRange(const QueryTerms& terms, int first_ordinal, int last_ordinal, DocumentPredicate document_predicate, const ResultWindow& window, std::vector<Document>& candidates) const {
+    const size_t result_count = window.count;
+    const size_t term_count = terms.plus_terms.size();
+    if (result_count == 0 || (term_count == 0 && !terms.matches_all_documents)) {
+        return;
+    }
+
+    // Слова упорядочиваются по возрастанию максимального вклада;
+    // bound_prefix[k] — сумма максимальных вкладов первых k слов
+    std::vector<size_t> order(term_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<double> max_scores(term_count);
+    for (size_t i = 0; i < term_count; ++i) {
+        max_scores[i] = terms.plus_terms[i].postings->GetMaxTermFreq() * terms.plus_terms[i].inverse_document_freq;
+    }
+    std::stable_sort(order.begin(), order.end(), [&max_scores](size_t lhs, size_t rhs) {
+        return max_scores[lhs] < max_scores[rhs];
+    });
+    std::vector<double> bound_prefix(term_count + 1);
+    std::vector<PostingList::Cursor> cursors;
+    cursors.reserve(term_count);
+    for (size_t k = 0; k < term_count; ++k) {
+        bound_prefix[k + 1] = bound_prefix[k] + max_scores[order[k]];
+        cursors.emplace_back(*terms.plus_terms[order[k]].postings);
+        cursors.back().SkipTo(first_ordinal);
+    }
+    // Большинство документов отсекается по верхней границе, поэтому минус-слова
+    // проверяются пропуском по спискам только для оставшихся кандидатов:
+    // это дешевле, чем строить битовую маску по всем вхождениям минус-слов
+    std::vector<PostingList::Cursor> minus_cursors;
+    minus_cursors.reserve(terms.minus_terms.size());
+    for (const PostingList* postings : terms.minus_terms) {
+        minus_cursors.emplace_back(*postings);
+    }
+
+    // Документ с релевантностью ниже threshold не может попасть в выдачу.
+    // Слова [0, first_essential) не способны сами по себе поднять документ до threshold,
+    // поэтому кандидаты перебираются только по остальным спискам.
+    // При matches_all_documents кандидатом остаётся каждый документ, пока threshold не выше нуля
+    std::priority_queue<double, std::vector<double>, std::greater<double>> top_relevances;
+    double threshold = -std::numeric_limits<double>::infinity();
+    size_t first_essential = 0;
+    int next_ordinal = first_ordinal;
+    std::vector<uint64_t> status_words;
+    const auto accepts_document = MakeDocumentAcceptor(document_predicate, status_words);
+    std::vector<double> term_freqs(term_count);
+    std::vector<bool> has_term(term_count);
+    // Минус-слова проверяются вперемешку с подсчётом, поэтому отдельно не замеряются:
+    // их время входит в QUERY_SCORE, а просмотренные вхождения — в POSTINGS_SCANNED
+    uint64_t postings_scanned = 0;
+    uint64_t documents_scored = 0;
+    while (true) {
+        int document_ordinal = last_ordinal;
+        for (size_t k = first_essential; k < term_count; ++k) {
+            document_ordinal = std::min(document_ordinal, cursors[k].GetDocumentOrdinal());
+        }
+        if (terms.matches_all_documents && threshold <= 0.0) {
+            while (next_ordinal < last_ordinal && documents_[next_ordinal].id == NO_DOCUMENT) {
+                ++next_ordinal;
+            }
+            document_ordinal = std::min(document_ordinal, next_ordinal);
+        }
+        if (document_ordinal >= last_ordinal) {
+            break;
+        }
+        next_ordinal = std::max(next_ordinal, document_ordinal + 1);
+
+        double score_bound = 0.0;
+        for (size_t k = first_essential; k < term_count; ++k) {
+            const size_t term = order[k];
+            has_term[term] = cursors[k].GetDocumentOrdinal() == document_ordinal;
+            if (has_term[term]) {
+                term_freqs[term] = cursors[k].GetTermFreq();
+                score_bound += term_freqs[term] * terms.plus_terms[term].inverse_document_freq;
+                cursors[k].Next();
+                ++postings_scanned;
+            }
+        }
+        if (!accepts_document(document_ordinal)) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+
+        bool is_candidate = true;
+        for (size_t k = first_essential; k-- > 0;) {
+            if (score_bound + bound_prefix[k + 1] < threshold) {
+                is_candidate = false;
+                break;
+            }
+            const size_t term = order[k];
+            cursors[k].SkipTo(document_ordinal);
+            ++postings_scanned;
+            has_term[term] = cursors[k].GetDocumentOrdinal() == document_ordinal;
+            if (has_term[term]) {
+                term_freqs[term] = cursors[k].GetTermFreq();
+                score_bound += term_freqs[term] * terms.plus_terms[term].inverse_document_freq;
             }
         }
-    }
+        if (!is_candidate || score_bound < threshold) {
+            continue;
+        }
+        for (PostingList::Cursor& cursor : minus_cursors) {
+            cursor.SkipTo(document_ordinal);
+            ++postings_scanned;
+            if (cursor.GetDocumentOrdinal() == document_ordinal) {
+                is_candidate = false;
+                break;
+            }
+        }
+        if (!is_candidate) {
+            continue;
+        }
 
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        double relevance = 0.0;
+        for (size_t term = 0; term < term_count; ++term) {
+            if (has_term[term]) {
+                relevance += term_freqs[term] * terms.plus_terms[term].inverse_document_freq;
+            }
+        }
+        const auto& document_data = documents_[document_ordinal];
+        ++documents_scored;
+        const Document document(document_data.id, relevance, document_data.rating);
+        // Документы предыдущих страниц не участвуют в отборе и не поднимают порог
+        if (window.after != nullptr && !IsRankedHigher(*window.after, document)) {
             continue;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        candidates.push_back(document);
+
+        top_relevances.push(relevance);
+        if (top_relevances.size() > result_count) {
+            top_relevances.pop();
+        }
+        if (top_relevances.size() == result_count && top_relevances.top() - EPSILON > threshold) {
+            threshold = top_relevances.top() - EPSILON;
+            while (first_essential < term_count && bound_prefix[first_essential + 1] < threshold) {
+                ++first_essential;
+            }
         }
     }
+    AddMetricCount(MetricCounter::POSTINGS_SCANNED, postings_scanned);
+    AddMetricCount(MetricCounter::DOCUMENTS_SCORED, documents_scored);
+}
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
-    }
-    return matched_documents;
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopCandidates(const std::execution::sequenced_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate) const {
+    return FindTopCandidates(policy, terms, document_predicate, ResultWindow{ static_cast<size_t>(max_result_document_count_) });
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy& policy, const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(query, document_predicate);
+std::vector<Document> SearchServer::FindTopCandidates(const std::execution::parallel_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate) const {
+    return FindTopCandidates(policy, terms, document_predicate, ResultWindow{ static_cast<size_t>(max_result_document_count_) });
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(128);
-    std::for_each(
-        policy,
-        query.plus_words.begin(),
-        query.plus_words.end(),
-        [this, document_predicate, &document_to_relevance](const std::string_view word) {
-            if (word_to_document_freqs_.count(word) != 0) {
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                        document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                    }
-                }
-            }
-        }
-    );
+std::vector<Document> SearchServer::FindTopCandidates(const std::execution::sequenced_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate, const ResultWindow& window) const {
+    std::vector<Document> candidates;
+    ScoreTopDocumentRange(terms, 0, static_cast<int>(documents_.size()), document_predicate, window, candidates);
+    return candidates;
+}
 
-    auto result = document_to_relevance.BuildOrdinaryMap();
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopCandidates(const std::execution::parallel_policy& policy, const QueryTerms& terms, DocumentPredicate document_predicate, const ResultWindow& window) const {
+    // Каждый поток ведёт собственный порог по своей части порядковых номеров
+    const int ordinal_count = static_cast<int>(documents_.size());
+    const int chunk_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+
+    std::vector<std::vector<Document>> chunk_candidates(chunk_count);
+    std::vector<int> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::for_each(policy, chunks.begin(), chunks.end(),
+        [this, &terms, &chunk_candidates, &window, document_predicate, ordinal_count, chunk_size](int chunk) {
+            const int first_ordinal = std::min(ordinal_count, chunk * chunk_size);
+            const int last_ordinal = std::min(ordinal_count, first_ordinal + chunk_size);
+            ScoreTopDocumentRange(terms, first_ordinal, last_ordinal, document_predicate, window, chunk_candidates[chunk]);
+        });
+
+    std::vector<Document> candidates;
+    for (const auto& documents : chunk_candidates) {
+        candidates.insert(candidates.end(), documents.begin(), documents.end());
+    }
+    return candidates;
+}
 
-    std::for_each(
-        policy,
-        query.minus_words.begin(),
-        query.minus_words.end(),
-        [this, document_predicate, &result](const std::string_view word) {
-            if (word_to_document_freqs_.count(word) != 0) {
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    result.erase(document_id);
+template <typename DocumentPredicate>
+auto SearchServer::MakeDocumentAcceptor(const DocumentPredicate& document_predicate, std::vector<uint64_t>& status_words) const {
+    if constexpr (std::is_same_v<DocumentPredicate, DocumentFilter>) {
+        const DocumentFilter& filter = document_predicate;
+        const uint64_t* status_bits = nullptr;
+        if (filter.status_mask != DocumentFilter::ALL_STATUSES) {
+            // Для одного статуса используется его маска без копирования
+            status_words.assign(status_bitmaps_[0].size(), 0);
+            status_bits = status_words.data();
+            for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+                if (filter.HasStatus(static_cast<DocumentStatus>(status))) {
+                    if (filter.status_mask == (1u << status)) {
+                        status_bits = status_bitmaps_[status].data();
+                        break;
+                    }
+                    std::transform(status_words.begin(), status_words.end(), status_bitmaps_[status].begin(), status_words.begin(), std::bit_or<uint64_t>());
                 }
             }
         }
-    );
-
-    std::vector<Document> matched_documents;
-    matched_documents.reserve(result.size());
-
-    for (const auto [document_id, relevance] : result) {
-        matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
+        const bool has_ranges = filter.HasRatingRange() || filter.HasIdRange();
+        return [this, status_bits, has_ranges, filter](int document_ordinal) {
+            if (status_bits != nullptr && ((status_bits[document_ordinal / 64] >> (document_ordinal % 64)) & 1) == 0) {
+                return false;
+            }
+            if (!has_ranges) {
+                return true;
+            }
+            const DocumentData& document_data = documents_[document_ordinal];
+            return document_data.rating >= filter.min_rating && document_data.rating <= filter.max_rating
+                && document_data.id >= filter.min_id && document_data.id <= filter.max_id;
+        };
     }
-    return matched_documents;
-}
\ No newline at end of file
+    else {
+        return [this, &document_predicate](int document_ordinal) {
+            const DocumentData& document_data = documents_[document_ordinal];
+            return document_predicate(document_data.id, document_data.status, document_data.rating);
+        };
+    }
+}
@@ -0,0 +1,109 @@
+#include "sharded_search_server.h"
+
+void ShardedSearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("ShardedSearchServer::AddDocument, invalid document id");
+    }
+    GetShard(document_id).AddDocument(document_id, document, status, ratings);
+    sorted_document_id_.insert(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const {
+    return FindTopDocuments(std::execution::par, raw_query, filter_status);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::par, raw_query);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(sorted_document_id_.size());
+}
+
+int ShardedSearchServer::GetShardCount() const {
+    return static_cast<int>(shards_.size());
+}
+
+void ShardedSearchServer::SetMaxResultDocumentCount(int count) {
+    for (SearchServer& shard : shards_) {
+        shard.SetMaxResultDocumentCount(count);
+    }
+    max_result_document_count_ = count;
+}
+
+int ShardedSearchServer::GetMaxResultDocumentCount() const {
+    return max_result_document_count_;
+}
+
+std::set<int>::const_iterator ShardedSearchServer::begin() const {
+    return sorted_document_id_.begin();
+}
+
+std::set<int>::const_iterator ShardedSearchServer::end() const {
+    return sorted_document_id_.end();
+}
+
+SearchServer::MatchDocumentFn ShardedSearchServer::MatchDocument(const std::string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(raw_query, document_id);
+}
+
+SearchServer::MatchDocumentFn ShardedSearchServer::MatchDocument(const std::execution::sequenced_policy& policy, const std::string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(policy, raw_query, document_id);
+}
+
+SearchServer::MatchDocumentFn ShardedSearchServer::MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(policy, raw_query, document_id);
+}
+
+const std::map<std::string_view, double>& ShardedSearchServer::GetWordFrequencies(int document_id) const {
+    return GetShard(document_id).GetWordFrequencies(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    GetShard(document_id).RemoveDocument(document_id);
+    sorted_document_id_.erase(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(const std::execution::sequenced_policy& policy, int document_id) {
+    return RemoveDocument(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(const std::execution::parallel_policy& policy, int document_id) {
+    GetShard(document_id).RemoveDocument(policy, document_id);
+    sorted_document_id_.erase(document_id);
+}
+
+const SearchServer& ShardedSearchServer::GetShard(int document_id) const {
+    const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(document_id)) * 0x9E3779B97F4A7C15ull;
+    return shards_[(hash >> 32) % shards_.size()];
+}
+
+SearchServer& ShardedSearchServer::GetShard(int document_id) {
+    return const_cast<SearchServer&>(static_cast<const ShardedSearchServer&>(*this).GetShard(document_id));
+}
+
+std::vector<double> ShardedSearchServer::ComputeInverseDocumentFreqs(const SearchServer::Query& query) const {
+    std::vector<double> inverse_document_freqs(query.plus_words.size());
+    const double log_document_count = log(static_cast<double>(GetDocumentCount()));
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        int document_freq = 0;
+        for (const SearchServer& shard : shards_) {
+            document_freq += shard.GetDocumentFreq(query.plus_words[i]);
+        }
+        if (document_freq > 0) {
+            inverse_document_freqs[i] = log_document_count - log(static_cast<double>(document_freq));
+        }
+    }
+    return inverse_document_freqs;
+}
+
+std::vector<Document> ShardedSearchServer::MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents) const {
+    std::vector<Document> result;
+    for (const auto& documents : shard_documents) {
+        result.insert(result.end(), documents.begin(), documents.end());
+    }
+    const size_t count = std::min(result.size(), static_cast<size_t>(max_result_document_count_));
+    std::partial_sort(result.begin(), result.begin() + count, result.end(), IsRankedHigher);
+    result.resize(count);
+    return result;
+}
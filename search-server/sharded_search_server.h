@@ -0,0 +1,114 @@
+#pragma once
+#include <execution>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Фасад над несколькими SearchServer: документы распределяются по шардам
+// по хешу id, запросы выполняются на всех шардах одновременно.
+// IDF считается по глобальной статистике, поэтому выдача совпадает с выдачей
+// одного SearchServer, содержащего все документы.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, int shard_count);
+
+    ShardedSearchServer(const std::string_view stop_words_text, int shard_count)
+        : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count) {
+    }
+
+    ShardedSearchServer(const std::string& stop_words_text, int shard_count)
+        : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count) {
+    }
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename Policy>
+    std::vector<Document> FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus filter_status) const;
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentStatus filter_status) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(const Policy& policy, const std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+    int GetShardCount() const;
+
+    void SetMaxResultDocumentCount(int count);
+    int GetMaxResultDocumentCount() const;
+
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
+
+    SearchServer::MatchDocumentFn MatchDocument(const std::string_view raw_query, int document_id) const;
+    SearchServer::MatchDocumentFn MatchDocument(const std::execution::sequenced_policy& policy, const std::string_view raw_query, int document_id) const;
+    SearchServer::MatchDocumentFn MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query, int document_id) const;
+
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+
+    void RemoveDocument(int document_id);
+    void RemoveDocument(const std::execution::sequenced_policy& policy, int document_id);
+    void RemoveDocument(const std::execution::parallel_policy& policy, int document_id);
+
+private:
+    std::vector<SearchServer> shards_;
+    std::set<int> sorted_document_id_;
+    int max_result_document_count_ = MAX_RESULT_DOCUMENT_COUNT;
+
+    const SearchServer& GetShard(int document_id) const;
+    SearchServer& GetShard(int document_id);
+
+    std::vector<double> ComputeInverseDocumentFreqs(const SearchServer::Query& query) const;
+    std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents) const;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, int shard_count) {
+    if (shard_count <= 0) {
+        throw std::invalid_argument("ShardedSearchServer (constructor): invalid shard count");
+    }
+    shards_.reserve(shard_count);
+    for (int i = 0; i < shard_count; ++i) {
+        shards_.emplace_back(stop_words);
+    }
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::par, raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate, typename Policy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    // Все шарды построены на одних стоп-словах, поэтому запрос разбирается один раз
+    const SearchServer::Query query = shards_.front().ParseQuery(raw_query);
+    const std::vector<double> inverse_document_freqs = ComputeInverseDocumentFreqs(query);
+
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    std::transform(policy, shards_.begin(), shards_.end(), shard_documents.begin(),
+        [&query, &inverse_document_freqs, document_predicate](const SearchServer& shard) {
+            auto matched_documents = shard.FindTopCandidates(std::execution::seq, shard.ResolveQueryTerms(query, inverse_document_freqs), document_predicate);
+            shard.SelectTopDocuments(std::execution::seq, matched_documents);
+            return matched_documents;
+        });
+
+    return MergeTopDocuments(shard_documents);
+}
+
+template <typename Policy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const Policy& policy, const std::string_view raw_query, DocumentStatus filter_status) const {
+    return FindTopDocuments(policy, raw_query, DocumentFilter(filter_status));
+}
+
+template <typename Policy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const Policy& policy, const std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
@@ -0,0 +1,39 @@
+#include "stop_words.h"
+
+size_t StopWordSet::size() const {
+    return words_.size();
+}
+
+bool StopWordSet::empty() const {
+    return words_.empty();
+}
+
+std::vector<std::string>::const_iterator StopWordSet::begin() const {
+    return words_.begin();
+}
+
+std::vector<std::string>::const_iterator StopWordSet::end() const {
+    return words_.end();
+}
+
+void StopWordSet::BuildIndex() {
+    size_t slot_count = 2;
+    while (slot_count < 2 * words_.size()) {
+        slot_count *= 2;
+    }
+    slots_.assign(slot_count, NO_WORD);
+    for (size_t i = 0; i < words_.size(); ++i) {
+        const std::string_view word = words_[i];
+        length_mask_ |= uint64_t{ 1 } << std::min<size_t>(word.size(), MAX_MASKED_LENGTH);
+        const uint64_t hash = HashStopWord(word);
+        const size_t first_bit = (hash >> 32) % BLOOM_BIT_COUNT;
+        const size_t second_bit = (hash >> 48) % BLOOM_BIT_COUNT;
+        bloom_[first_bit / 64] |= uint64_t{ 1 } << (first_bit % 64);
+        bloom_[second_bit / 64] |= uint64_t{ 1 } << (second_bit % 64);
+        size_t slot = hash & (slot_count - 1);
+        while (slots_[slot] != NO_WORD) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots_[slot] = static_cast<int>(i);
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_processing.h"
+
+// FNV-1a. Функция constexpr, чтобы таблицы стоп-слов можно было строить при компиляции
+constexpr uint64_t HashStopWord(std::string_view word) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : word) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash ^ (hash >> 32);
+}
+
+// Множество стоп-слов, неизменное после построения. Слово сначала проверяется по маске длин
+// и фильтру Блума, затем ищется в хеш-таблице с открытой адресацией, заполненной не больше
+// чем наполовину: обычно это один хеш и одно сравнение строк
+class StopWordSet {
+public:
+    StopWordSet() = default;
+
+    template <typename StringContainer>
+    explicit StopWordSet(const StringContainer& words);
+
+    bool Contains(std::string_view word) const {
+        if (((length_mask_ >> std::min<size_t>(word.size(), MAX_MASKED_LENGTH)) & 1) == 0) {
+            return false;
+        }
+        const uint64_t hash = HashStopWord(word);
+        const size_t first_bit = (hash >> 32) % BLOOM_BIT_COUNT;
+        const size_t second_bit = (hash >> 48) % BLOOM_BIT_COUNT;
+        if (((bloom_[first_bit / 64] >> (first_bit % 64)) & (bloom_[second_bit / 64] >> (second_bit % 64)) & 1) == 0) {
+            return false;
+        }
+        const size_t slot_mask = slots_.size() - 1;
+        for (size_t slot = hash & slot_mask; slots_[slot] != NO_WORD; slot = (slot + 1) & slot_mask) {
+            if (words_[slots_[slot]] == word) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const;
+    bool empty() const;
+
+    // Слова в порядке возрастания
+    std::vector<std::string>::const_iterator begin() const;
+    std::vector<std::string>::const_iterator end() const;
+
+private:
+    static constexpr int NO_WORD = -1;
+    // Длины от 63 и больше делят один бит маски
+    static constexpr size_t MAX_MASKED_LENGTH = 63;
+    static constexpr size_t BLOOM_BIT_COUNT = 512;
+
+    std::vector<std::string> words_;
+    std::vector<int> slots_;
+    uint64_t length_mask_ = 0;
+    std::array<uint64_t, BLOOM_BIT_COUNT / 64> bloom_{};
+
+    void BuildIndex();
+};
+
+template <typename StringContainer>
+StopWordSet::StopWordSet(const StringContainer& words) {
+    const auto unique_words = MakeUniqueNonEmptyStrings(words);
+    words_.assign(unique_words.begin(), unique_words.end());
+    BuildIndex();
+}
+
+// Стоп-слова, известные при компиляции; таблица строится constexpr-конструктором:
+//     constexpr StaticStopWords stop_words(std::array<std::string_view, 2>{ "in"sv, "the"sv });
+//     static_assert(stop_words.Contains("in"sv));
+// Годится и как контейнер стоп-слов для конструктора SearchServer
+template <size_t N>
+class StaticStopWords {
+public:
+    constexpr explicit StaticStopWords(const std::array<std::string_view, N>& words)
+        : words_(words) {
+        for (size_t i = 0; i < N; ++i) {
+            if (words[i].empty() || Contains(words[i])) {
+                continue;
+            }
+            size_t slot = HashStopWord(words[i]) & (SLOT_COUNT - 1);
+            while (slots_[slot] != 0) {
+                slot = (slot + 1) & (SLOT_COUNT - 1);
+            }
+            slots_[slot] = i + 1;
+        }
+    }
+
+    constexpr bool Contains(std::string_view word) const {
+        for (size_t slot = HashStopWord(word) & (SLOT_COUNT - 1); slots_[slot] != 0; slot = (slot + 1) & (SLOT_COUNT - 1)) {
+            if (words_[slots_[slot] - 1] == word) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr auto begin() const {
+        return words_.begin();
+    }
+
+    constexpr auto end() const {
+        return words_.end();
+    }
+
+private:
+    static constexpr size_t ComputeSlotCount() {
+        size_t slot_count = 2;
+        while (slot_count < 2 * N) {
+            slot_count *= 2;
+        }
+        return slot_count;
+    }
+
+    static constexpr size_t SLOT_COUNT = ComputeSlotCount();
+
+    std::array<std::string_view, N> words_;
+    // Номер слова плюс один; ноль — пустая ячейка
+    std::array<size_t, SLOT_COUNT> slots_{};
+};
@@ -1,13 +1,105 @@
 #include "string_processing.h"
 
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+const size_t NO_WORD = static_cast<size_t>(-1);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#ifdef __AVX2__
+const size_t CHUNK_SIZE = 32;
+const uint32_t CHUNK_BITS = ~uint32_t{ 0 };
+
+// Маски пробелов и управляющих символов в 32 байтах текста
+void ClassifyChunk(const char* data, uint32_t& space_mask, uint32_t& control_mask) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '))));
+    control_mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(' ' - 1)), bytes)));
+}
+#else
+const size_t CHUNK_SIZE = 16;
+const uint32_t CHUNK_BITS = 0xFFFF;
+
+// Маски пробелов и управляющих символов в 16 байтах текста
+void ClassifyChunk(const char* data, uint32_t& space_mask, uint32_t& control_mask) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '))));
+    control_mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(' ' - 1)), bytes)));
+}
+#endif
+
+int CountTrailingZeros(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int count = 0;
+    for (; (mask & 1) == 0; mask >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+#endif
+}
+
 std::vector<std::string_view> SplitIntoWords(const std::string_view text) {
     std::vector<std::string_view> result;
-    int64_t pos = text.find_first_not_of(" ");
-    const int64_t pos_end = text.npos;
-    while (pos != pos_end) {
-        int64_t space = text.find(' ', pos);
-        result.emplace_back(space == pos_end ? text.substr(pos) : text.substr(pos, space - pos));
-        pos = text.find_first_not_of(" ", space);
-    }
+    SplitIntoWords(text, result);
     return result;
-}
\ No newline at end of file
+}
+
+bool SplitIntoWords(const std::string_view text, std::vector<std::string_view>& words) {
+    words.clear();
+    const char* data = text.data();
+    const size_t size = text.size();
+    size_t word_begin = NO_WORD;
+    uint32_t control_found = 0;
+    size_t pos = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    // Границы слов — позиции, где пробел сменяется другим символом или наоборот;
+    // перед текстом считается пробел
+    uint32_t previous_is_space = 1;
+    for (; pos + CHUNK_SIZE <= size; pos += CHUNK_SIZE) {
+        uint32_t space_mask;
+        uint32_t control_mask;
+        ClassifyChunk(data + pos, space_mask, control_mask);
+        control_found |= control_mask;
+        uint32_t boundaries = (space_mask ^ ((space_mask << 1) | previous_is_space)) & CHUNK_BITS;
+        previous_is_space = (space_mask >> (CHUNK_SIZE - 1)) & 1;
+        while (boundaries != 0) {
+            const size_t boundary = pos + CountTrailingZeros(boundaries);
+            boundaries &= boundaries - 1;
+            if (word_begin == NO_WORD) {
+                word_begin = boundary;
+            }
+            else {
+                words.emplace_back(data + word_begin, boundary - word_begin);
+                word_begin = NO_WORD;
+            }
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        const char c = data[pos];
+        control_found |= c >= '\0' && c < ' ';
+        if (c == ' ') {
+            if (word_begin != NO_WORD) {
+                words.emplace_back(data + word_begin, pos - word_begin);
+                word_begin = NO_WORD;
+            }
+        }
+        else if (word_begin == NO_WORD) {
+            word_begin = pos;
+        }
+    }
+    if (word_begin != NO_WORD) {
+        words.emplace_back(data + word_begin, size - word_begin);
+    }
+    return control_found == 0;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 #include <string>
@@ -7,6 +8,10 @@
 #include <set>
 
 std::vector<std::string_view> SplitIntoWords(const std::string_view text);
+// Разбивает текст на слова за один проход, одновременно проверяя, что в нём нет
+// управляющих символов (коды 0-31). Слова записываются в words: буфер очищается,
+// но его память переиспользуется между вызовами. Возвращает false, если найден управляющий символ
+bool SplitIntoWords(const std::string_view text, std::vector<std::string_view>& words);
 
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
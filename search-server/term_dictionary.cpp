@@ -0,0 +1,53 @@
+#include "term_dictionary.h"
+
+int TermDictionary::Find(const std::string_view term) const {
+    const auto it = term_to_id_.find(term);
+    return it == term_to_id_.end() ? NO_TERM : it->second;
+}
+
+int TermDictionary::Acquire(const std::string_view term, int references) {
+    int term_id = Find(term);
+    if (term_id == NO_TERM) {
+        if (free_ids_.empty()) {
+            term_id = static_cast<int>(entries_.size());
+            entries_.emplace_back();
+        }
+        else {
+            term_id = free_ids_.back();
+            free_ids_.pop_back();
+        }
+        entries_[term_id].text = term;
+        term_to_id_.emplace(entries_[term_id].text, term_id);
+    }
+    entries_[term_id].references += references;
+    return term_id;
+}
+
+bool TermDictionary::Release(int term_id, int references) {
+    Entry& entry = entries_[term_id];
+    entry.references -= references;
+    if (entry.references > 0) {
+        return false;
+    }
+    term_to_id_.erase(entry.text);
+    std::string().swap(entry.text);
+    entry.references = 0;
+    free_ids_.push_back(term_id);
+    return true;
+}
+
+std::string_view TermDictionary::GetTerm(int term_id) const {
+    return entries_[term_id].text;
+}
+
+int TermDictionary::GetReferenceCount(int term_id) const {
+    return entries_[term_id].references;
+}
+
+size_t TermDictionary::GetIdBound() const {
+    return entries_.size();
+}
+
+size_t TermDictionary::size() const {
+    return term_to_id_.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Хранилище уникальных слов индекса. Каждое слово хранится один раз и получает
+// плотный id; счётчик ссылок равен числу документов, содержащих слово.
+// Когда счётчик обнуляется, строка освобождается, а id переиспользуется.
+// string_view, возвращаемые GetTerm, действительны, пока слово есть в словаре.
+class TermDictionary {
+public:
+    static constexpr int NO_TERM = -1;
+
+    int Find(const std::string_view term) const;
+    int Acquire(const std::string_view term, int references = 1);
+    // Возвращает true, если слово было удалено из словаря
+    bool Release(int term_id, int references = 1);
+
+    std::string_view GetTerm(int term_id) const;
+    int GetReferenceCount(int term_id) const;
+
+    // Граница диапазона id: все id слов меньше этого значения
+    size_t GetIdBound() const;
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string text;
+        int references = 0;
+    };
+
+    std::deque<Entry> entries_;
+    std::unordered_map<std::string_view, int> term_to_id_;
+    std::vector<int> free_ids_;
+};